@@ -0,0 +1,402 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include "../include/Chip8.h"
+#include "../include/RomCache.h"
+
+/*
+* chip8-bench: micro benchmarks (each OP_* handler, dispatch strategies, DXYN, 00E0, LoadROM, save states)
+* and macro benchmarks (whole frames of the bundled ROMs).
+*
+* Every benchmark runs a few warmup repetitions, then --reps timed repetitions of a fixed amount of work;
+* the JSON output has the median, p10/p90 and min time per operation in nanoseconds (one benchmark per line).
+*
+* Usage: chip8-bench [--reps N] [--filter text] [--roms dir] [--out results.json] [--baseline old.json] [--threshold percent]
+*
+* With --baseline, every benchmark's median is compared to the saved one (table on stderr) and the exit code is 1 if any got slower
+* by more than --threshold percent (default 5).
+*/
+struct BenchResult {
+    std::string name;
+    double median = 0;
+    double p10 = 0;
+    double p90 = 0;
+    double min = 0;
+    int reps = 0;
+};
+
+struct BenchOptions {
+    int reps = 15;
+    int warmup = 3;
+    std::string filter;
+    std::string romDir = "src/";
+};
+
+// Runs body() warmup + reps times; each call does `operations` units of work. Results are ns per operation.
+static BenchResult Measure(const std::string& name, const BenchOptions& options, double operations, const std::function<void()>& body) {
+    for (int i = 0; i < options.warmup; ++i) {
+        body();
+    }
+    std::vector<double> samples;
+    for (int i = 0; i < options.reps; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        samples.push_back(elapsed.count() / operations);
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        // Nearest rank
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+        return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    };
+    BenchResult result;
+    result.name = name;
+    result.median = samples.size() % 2 ? samples[samples.size() / 2] : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+    result.p10 = percentile(10);
+    result.p90 = percentile(90);
+    result.min = samples.front();
+    result.reps = options.reps;
+    return result;
+}
+
+static std::vector<uint8_t> ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Fills program memory with one opcode per address (opcodeAt(address)), ending in a jump back to 0x200
+static void FillProgram(Chip8& chip, const std::function<uint16_t(uint16_t)>& opcodeAt) {
+    for (uint16_t address = 0x200; address < 0xFFE; address += 2) {
+        uint16_t op = opcodeAt(address);
+        chip.memory[address] = op >> 8;
+        chip.memory[address + 1] = op & 0xFF;
+    }
+    chip.memory[0xFFE] = 0x12;
+    chip.memory[0xFFF] = 0x00;
+    chip.NotifyMemoryWrite(0x200, 0xE00);
+}
+
+struct HandlerCase {
+    const char* name;
+    std::function<uint16_t(uint16_t)> opcodeAt;
+    std::function<void(Chip8&)> setup;  // Registers/keys so skips aren't taken and the loop stays straight-line
+};
+
+static std::vector<HandlerCase> HandlerCases() {
+    auto same = [](uint16_t op) { return [op](uint16_t) { return op; }; };
+    auto none = [](Chip8&) {};
+    return {
+        { "OP_0nnn (SYS, ignored)", same(0x0123), none },
+        { "OP_1nnn", [](uint16_t a) { return static_cast<uint16_t>(0x1000 | (a + 2)); }, none },
+        // 2NNN to a 00EE two instructions ahead, which returns to a 1NNN skipping over it: call + return + jump per 3 instructions
+        { "OP_2nnn+OP_00EE+OP_1nnn", [](uint16_t a) {
+            switch ((a - 0x200) / 2 % 3) {
+            case 0: return static_cast<uint16_t>(0x2000 | (a + 4));
+            case 1: return static_cast<uint16_t>(0x1000 | (a + 4));
+            default: return static_cast<uint16_t>(0x00EE);
+            } }, none },
+        { "OP_3xnn", same(0x3001), none },
+        { "OP_4xnn", same(0x4000), none },
+        { "OP_5xy0", same(0x5010), [](Chip8& c) { c.registers[1] = 1; } },
+        { "OP_6xnn", same(0x6012), none },
+        { "OP_7xnn", same(0x7001), none },
+        { "OP_8xy0", same(0x8010), none },
+        { "OP_8xy1", same(0x8011), none },
+        { "OP_8xy2", same(0x8012), none },
+        { "OP_8xy3", same(0x8013), none },
+        { "OP_8xy4", same(0x8014), [](Chip8& c) { c.registers[1] = 3; } },
+        { "OP_8xy5", same(0x8015), [](Chip8& c) { c.registers[1] = 3; } },
+        { "OP_8xy6", same(0x8016), none },
+        { "OP_8xy7", same(0x8017), [](Chip8& c) { c.registers[1] = 3; } },
+        { "OP_8xyE", same(0x801E), none },
+        { "OP_9xy0", same(0x9010), none },
+        { "OP_Annn", same(0xA300), none },
+        { "OP_Bnnn", [](uint16_t a) { return static_cast<uint16_t>(0xB000 | (a + 2)); }, none },
+        { "OP_Cxnn", same(0xC0FF), none },
+        { "OP_Dxyn", same(0xD015), [](Chip8& c) { c.index = 0x050; c.registers[0] = 10; c.registers[1] = 7; } },
+        { "OP_Ex9E", same(0xE09E), none },
+        { "OP_ExA1", same(0xE0A1), [](Chip8& c) { c.keypad[0] = 1; } },
+        { "OP_Fx07", same(0xF007), none },
+        { "OP_Fx0A (key down)", same(0xF00A), [](Chip8& c) { c.keypad[5] = 1; } },
+        { "OP_Fx15", same(0xF015), none },
+        { "OP_Fx18", same(0xF018), none },
+        { "OP_Fx1E", same(0xF01E), [](Chip8& c) { c.registers[0] = 1; } },
+        { "OP_Fx29", same(0xF029), none },
+        { "OP_Fx33", same(0xF033), [](Chip8& c) { c.index = 0x100; c.registers[0] = 123; } },
+        { "OP_Fx55 (V0-V3)", same(0xF355), [](Chip8& c) { c.index = 0x100; } },
+        { "OP_Fx65 (V0-V3)", same(0xF365), [](Chip8& c) { c.index = 0x100; } },
+    };
+}
+
+static std::vector<BenchResult> RunAll(const BenchOptions& options) {
+    std::vector<BenchResult> results;
+    auto wanted = [&](const std::string& name) { return options.filter.empty() || name.find(options.filter) != std::string::npos; };
+    auto add = [&](const std::string& name, double operations, const std::function<void()>& body) {
+        if (wanted(name)) {
+            results.push_back(Measure(name, options, operations, body));
+            std::clog << name << ": " << results.back().median << " ns" << std::endl;  // Progress
+        }
+    };
+
+    // Handlers, one opcode repeated through Cycle() (dispatch included)
+    constexpr int handlerOps = 200000;
+    for (const HandlerCase& handler : HandlerCases()) {
+        auto chip = std::make_unique<Chip8>(1);
+        FillProgram(*chip, handler.opcodeAt);
+        handler.setup(*chip);
+        add("handler/" + std::string(handler.name), handlerOps, [&]() {
+            for (int i = 0; i < handlerOps; ++i) {
+                chip->Cycle();
+            }
+        });
+    }
+
+    // 00E0 on a full screen (refilled every time so the clear always has work to do)
+    {
+        auto chip = std::make_unique<Chip8>(1);
+        FillProgram(*chip, [](uint16_t) { return static_cast<uint16_t>(0x00E0); });
+        constexpr int clears = 100000;
+        add("display/00E0 clear", clears, [&]() {
+            for (int i = 0; i < clears; ++i) {
+                std::fill(std::begin(chip->display), std::end(chip->display), ~0ull);
+                chip->Cycle();
+            }
+        });
+    }
+    // DXYN: 15-row sprites at positions that cover clipping, wrapping and byte-misaligned x
+    {
+        auto chip = std::make_unique<Chip8>(1);
+        FillProgram(*chip, [](uint16_t a) { return static_cast<uint16_t>(0xD01F | ((a / 2 % 2) << 4)); });
+        chip->index = 0x200;
+        constexpr int draws = 200000;
+        add("display/Dxyn 8x15 sprite", draws, [&]() {
+            for (int i = 0; i < draws; ++i) {
+                chip->registers[0] = static_cast<uint8_t>(i * 7);
+                chip->registers[1] = static_cast<uint8_t>(i * 3);
+                chip->Cycle();
+            }
+        });
+    }
+
+    std::vector<uint8_t> ibm = ReadFile(options.romDir + "IBMTest.ch8");
+    std::vector<uint8_t> pong = ReadFile(options.romDir + "WonkyPong.ch8");
+    if (ibm.empty() || pong.empty()) {
+        std::clog << "ROMs not found in " << options.romDir << " (use --roms), skipping ROM benchmarks" << std::endl;
+        return results;
+    }
+
+    // Dispatch strategies on a real program
+    {
+        constexpr int instructions = 1000000;
+        auto chip = std::make_unique<Chip8>(1);
+        chip->LoadROM(std::span<const uint8_t>(pong));
+        add("dispatch/switch (CycleSwitch)", instructions, [&]() {
+            for (int i = 0; i < instructions; ++i) {
+                chip->CycleSwitch();
+            }
+        });
+        add("dispatch/table (Cycle)", instructions, [&]() {
+            for (int i = 0; i < instructions; ++i) {
+                chip->Cycle();
+            }
+        });
+        add("dispatch/threaded (RunThreaded)", instructions, [&]() {
+            chip->RunThreaded(instructions);
+        });
+    }
+
+    // LoadROM from memory, from disk (read every time) and from the shared ROM cache
+    {
+        auto chip = std::make_unique<Chip8>(1);
+        constexpr int loads = 20000;
+        add("rom/LoadROM span WonkyPong", loads, [&]() {
+            for (int i = 0; i < loads; ++i) {
+                chip->LoadROM(std::span<const uint8_t>(pong));
+            }
+        });
+        constexpr int fileLoads = 500;
+        std::string path = options.romDir + "WonkyPong.ch8";
+        add("rom/LoadROM file WonkyPong", fileLoads, [&]() {
+            for (int i = 0; i < fileLoads; ++i) {
+                chip->LoadROM(path);
+            }
+        });
+        // What a farm pays per reset: cache lookup of the already read image + the copy to 0x200
+        add("rom/LoadROM RomCache WonkyPong", loads, [&]() {
+            for (int i = 0; i < loads; ++i) {
+                chip->LoadROM(RomCache::Shared().Load(path));
+            }
+        });
+    }
+
+    // Starting a short episode over: a fresh instance vs Reset() after a few frames of play
+    {
+        constexpr int resets = 2000;
+        add("reset/new Chip8 + LoadROM WonkyPong", resets, [&]() {
+            for (int i = 0; i < resets; ++i) {
+                auto fresh = std::make_unique<Chip8>(1);
+                fresh->LoadROM(std::span<const uint8_t>(pong));
+            }
+        });
+        auto chip = std::make_unique<Chip8>(1);
+        chip->LoadROM(std::span<const uint8_t>(pong));
+        add("reset/4 frames + Reset WonkyPong", resets, [&]() {
+            for (int i = 0; i < resets; ++i) {
+                for (int f = 0; f < 4; ++f) {
+                    chip->RunUntilFrame(chip->instructionsPerFrame);
+                }
+                chip->Reset();
+            }
+        });
+    }
+
+    // Save states
+    {
+        auto chip = std::make_unique<Chip8>(1);
+        chip->LoadROM(std::span<const uint8_t>(pong));
+        for (int f = 0; f < 100; ++f) {
+            chip->RunUntilFrame(chip->instructionsPerFrame);
+        }
+        std::vector<uint8_t> state(Chip8::saveStateSize);
+        constexpr int saves = 100000;
+        add("state/SaveState", saves, [&]() {
+            for (int i = 0; i < saves; ++i) {
+                chip->SaveState(state);
+            }
+        });
+        add("state/LoadState", saves, [&]() {
+            for (int i = 0; i < saves; ++i) {
+                chip->LoadState(state);
+            }
+        });
+    }
+
+    // Whole frames: what a frontend or the farm actually pays per 60Hz frame
+    struct FrameCase {
+        const char* name;
+        const std::vector<uint8_t>* rom;
+        int instructionsPerFrame;
+        bool skipIdle;
+    };
+    const FrameCase frames[] = {
+        { "frame/IBMTest ipf=11", &ibm, 11, true },
+        { "frame/IBMTest ipf=11 no idle skip", &ibm, 11, false },
+        { "frame/WonkyPong ipf=11", &pong, 11, true },
+        { "frame/WonkyPong ipf=1000", &pong, 1000, true },
+    };
+    for (const FrameCase& frame : frames) {
+        auto chip = std::make_unique<Chip8>(1);
+        chip->LoadROM(std::span<const uint8_t>(*frame.rom));
+        chip->instructionsPerFrame = frame.instructionsPerFrame;
+        chip->skipIdleLoops = frame.skipIdle;
+        constexpr int frameCount = 2000;
+        add(frame.name, frameCount, [&]() {
+            for (int f = 0; f < frameCount; ++f) {
+                uint64_t start = chip->frameCount;
+                while (chip->frameCount == start) {
+                    chip->RunUntilFrame(frame.instructionsPerFrame);
+                    chip->drawFlag = false;
+                }
+            }
+        });
+    }
+    return results;
+}
+
+static void WriteJson(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "{\"unit\": \"ns/op\", \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "  {\"name\": \"" << r.name << "\", \"median\": " << r.median << ", \"p10\": " << r.p10 << ", \"p90\": " << r.p90
+            << ", \"min\": " << r.min << ", \"reps\": " << r.reps << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]}\n";
+}
+
+// Reads the name/median pairs back from a file written by WriteJson (one benchmark per line)
+static bool LoadBaseline(const std::string& path, std::map<std::string, double>& medians) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open baseline: " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t name = line.find("\"name\": \"");
+        size_t median = line.find("\"median\": ");
+        if (name == std::string::npos || median == std::string::npos) {
+            continue;
+        }
+        name += 9;
+        medians[line.substr(name, line.find('"', name) - name)] = std::stod(line.substr(median + 10));
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    std::string outPath;
+    std::string baselinePath;
+    double threshold = 5.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Usage: chip8-bench [--reps N] [--filter text] [--roms dir] [--out results.json] [--baseline old.json] [--threshold percent]" << std::endl;
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--reps") options.reps = std::max(1, std::stoi(value));
+        else if (arg == "--filter") options.filter = value;
+        else if (arg == "--roms") options.romDir = value.empty() || value.back() == '/' || value.back() == '\\' ? value : value + "/";
+        else if (arg == "--out") outPath = value;
+        else if (arg == "--baseline") baselinePath = value;
+        else if (arg == "--threshold") threshold = std::stod(value);
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    std::map<std::string, double> baseline;
+    if (!baselinePath.empty() && !LoadBaseline(baselinePath, baseline)) {
+        return 2;
+    }
+
+    std::vector<BenchResult> results = RunAll(options);
+
+    if (outPath.empty()) {
+        WriteJson(std::cout, results);
+    }
+    else {
+        std::ofstream out(outPath);
+        WriteJson(out, results);
+    }
+
+    if (baseline.empty()) {
+        return 0;
+    }
+    int regressions = 0;
+    std::fprintf(stderr, "%-40s %12s %12s %9s\n", "benchmark", "baseline ns", "current ns", "change");
+    for (const BenchResult& r : results) {
+        auto old = baseline.find(r.name);
+        if (old == baseline.end() || old->second <= 0) {
+            std::fprintf(stderr, "%-40s %12s %12.2f %9s\n", r.name.c_str(), "-", r.median, "new");
+            continue;
+        }
+        double change = (r.median - old->second) / old->second * 100.0;
+        bool regressed = change > threshold;
+        regressions += regressed;
+        std::fprintf(stderr, "%-40s %12.2f %12.2f %+8.1f%%%s\n", r.name.c_str(), old->second, r.median, change, regressed ? "  REGRESSION" : "");
+    }
+    return regressions > 0 ? 1 : 0;
+}
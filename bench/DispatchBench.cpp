@@ -0,0 +1,68 @@
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <string>
+#include "../include/Chip8.h"
+
+/*
+* Dispatch micro-benchmark: runs the bundled ROMs with the three ways Chip8 can decode/dispatch an instruction
+* - switch:   CycleSwitch(), nested switch decode + call through the handler table (the original Cycle())
+* - table:    Cycle(), constexpr 64K dispatch table + switch on the handler id (handlers inlined)
+* - threaded: RunThreaded(), computed goto (only different from "table" when built with CHIP8_THREADED_DISPATCH on GCC/Clang)
+*
+* Usage: chip8-dispatch-bench [instructions] [rom...]
+*/
+enum class Strategy { Switch, Table, Threaded };
+
+static double Run(const std::string& rom, Strategy strategy, int instructions) {
+    auto emulator = std::make_unique<Chip8>(1);  // Same random sequence for every strategy
+    if (!emulator->LoadROM(rom)) {
+        std::cerr << emulator->loadError << ": " << rom << std::endl;
+        return 0.0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    switch (strategy) {
+    case Strategy::Switch:
+        for (int i = 0; i < instructions; ++i) {
+            emulator->CycleSwitch();
+        }
+        break;
+    case Strategy::Table:
+        for (int i = 0; i < instructions; ++i) {
+            emulator->Cycle();
+        }
+        break;
+    case Strategy::Threaded:
+        emulator->RunThreaded(instructions);
+        break;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return instructions / elapsed.count() / 1e6;  // Million instructions per second
+}
+
+int main(int argc, char* argv[]) {
+    int instructions = argc > 1 ? std::stoi(argv[1]) : 50000000;
+    std::string roms[] = { "src/IBMTest.ch8", "src/WonkyPong.ch8" };
+    int romCount = 2;
+    if (argc > 2) {
+        romCount = 0;
+        for (int i = 2; i < argc && romCount < 2; ++i) {
+            roms[romCount++] = argv[i];
+        }
+    }
+
+#if defined(CHIP8_THREADED_DISPATCH) && (defined(__GNUC__) || defined(__clang__))
+    std::cout << "Threaded dispatch: computed goto" << std::endl;
+#else
+    std::cout << "Threaded dispatch: not compiled in (falls back to Cycle loop)" << std::endl;
+#endif
+    const char* names[] = { "switch", "table", "threaded" };
+    for (int r = 0; r < romCount; ++r) {
+        for (int s = 0; s < 3; ++s) {
+            double mips = Run(roms[r], static_cast<Strategy>(s), instructions);
+            std::cout << roms[r] << " " << names[s] << ": " << mips << " M instructions/s" << std::endl;
+        }
+    }
+    return 0;
+}
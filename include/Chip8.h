@@ -1,18 +1,60 @@
+#pragma once
 #include <cstdint>
-#include <fstream>
-#include <random>
+#include <array>
+#include <span>
+#include <string>
 #include <chrono>
+#include <memory>
+#include "Rng.h"
+
+class Chip8Profiler;
+class RomFile;
 
 // http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
 // https://chip-8.github.io/links/
 class Chip8 {
 public:
 
-    Chip8();
-    bool LoadROM(const std::string filename); // Takes a filename, reads the file in binary mode, and copies its contents into memory from 0x200 onward. It returns bool (true on success, false if file not found or too big).
+    Chip8();                        // Seeds the RNG from the clock (every run is different)
+    explicit Chip8(unsigned seed);  // Fixed RNG seed: same ROM + same input = same run (replays, tests, batch runs)
+    bool LoadROM(const std::string& filename); // Takes a filename, reads the file (RomCache.h), and copies its contents into memory from 0x200 onward. It returns bool (true on success, false if file not found or too big).
+    bool LoadROM(std::span<const uint8_t> rom); // Same as above but copies from a buffer already in memory (no file I/O, the bytes are copied into a private image for Reset, reused by the next call)
+    bool LoadROM(std::shared_ptr<const RomFile> image); // Same, from a shared image (RomCache): no copy besides memory, every instance keeps a reference to the same bytes
+                                    // After any LoadROM memory is exactly font + ROM + zeros, whatever ran before
+    void Reset();                   // Back to the state right after the last LoadROM (same seed), without re-running the constructor (see romImage)
+    void Reset(unsigned seed);      // Same, with a new RNG seed
     void Cycle();
+    void CycleSwitch();             // Same as Cycle() but decodes with the nested switch and calls through handlerTable (reference/benchmark only)
+    int RunThreaded(int cycles);    // Runs `cycles` instructions with computed-goto dispatch when built with CHIP8_THREADED_DISPATCH on GCC/Clang
+    int RunCycles(int cycles);      // Runs up to `cycles` instructions, ticking the timers every instructionsPerFrame. Returns early once drawFlag is set or FX0A is waiting for a key
+    int RunUntilFrame(int perFrame); // Runs to the end of the current 60Hz frame of perFrame instructions (then ticks the timers). Returns early once drawFlag is set.
+                                    // Idle loops are fast-forwarded (see idle): returns the instructions that actually ran, the skipped ones go to skippedInstructions
+    void TickTimers();              // One 60Hz tick: decrements delayTimer/soundTimer and counts the frame
+    void RenderRGBA(uint32_t* pixels) const; // Expands display into 64*32 RGBA32 pixels (0xFFFFFFFF on, 0x00000000 off), row by row
+    bool GetPixel(int x, int y) const { return (display[y] >> (63 - x)) & 1; }
+
+    struct DirtyRect {
+        uint8_t x, y, w, h;         // Changed area in display pixels
+    };
+    int GetDirtyRegions(DirtyRect* rects, int maxRects) const; // Groups the rows changed since ClearDirty() into rectangles, returns how many were written
+    void ClearDirty();              // Call after presenting/encoding a frame
+    uint64_t DisplayHash() const;   // FNV-1a hash of the display rows, for comparing runs without storing frames
+    void NotifyMemoryWrite(uint16_t address, uint16_t length); // Call after writing memory[address..address+length) directly: drops compiled code there (code write hooks) and marks the pages for Reset()
+
+    // Save states: a fixed-size, versioned binary blob of the whole machine (see SaveState in Chip8.cpp for the layout)
+    static constexpr uint16_t saveStateVersion = 2;
+    static constexpr size_t saveStateSize = 8 + 4096 + 16 + 2 + 2 + 32 + 3 + 2 + 256 + 2 + 4 + 8 + 1 + 4 // Header, memory, V0-VF, I, PC, stack, SP + timers, keypad bits, display rows, opcode, frame counters, FX0A wait, seed
+        + Chip8Rng::stateBytes;     // RNG state
+    size_t SaveState(std::span<uint8_t> buffer) const;   // Writes saveStateSize bytes into buffer (no allocation), returns 0 if the buffer is too small
+    bool LoadState(std::span<const uint8_t> state);      // Restores a SaveState blob, false (machine untouched) if it's from another version or RNG policy, or corrupt (SP past the stack)
 
     uint8_t memory[4096] = {};  // 4KB of RAM (0x000 to 0xFFF)
+                                /*
+                                * Code outside the core that writes memory directly (patching a ROM, a debugger poking bytes) must call
+                                * NotifyMemoryWrite(address, length) afterwards. That's the only way the write is seen: Reset() and LoadROM
+                                * only rebuild the 64-byte pages marked there (an unmarked write survives them), and JIT/AOT code compiled
+                                * from those bytes is only dropped through the code write hooks. Writes made by the opcodes and LoadState are marked already.
+                                */
     uint8_t registers[16] = {}; // V0 to VF registers (V0 through VF - registers[0] => V0 & registers[15] => VF)
 
     uint16_t index = 0;             // I register (16-bit, for addressing) needed for pointing to memory addresses in operations like loading/storing multiple registers and drawing sprites
@@ -30,17 +72,38 @@ public:
                                     * Chip-8 originally used a 4x4 hex keypad (like old calculators: rows 1-2-3-C, 4-5-6-D, etc.)
                                     * In our case we are gonna use 16 keys for hex input (0-9, A-F)
                                     */
-    uint32_t gfx[64 * 32] = {};     // Display buffer (64 wide x 32 tall)
-                                    /* 
-                                    * Serve as a framebuffer for the display.
-                                    * Chip-8 screen is 64 pixels wide by 32 tall (total 2048 pixels).
-                                    * Each element represents one pixel: 0x00000000 means "off" (black), 0xFFFFFFFF means "on" (white).
-                                    * The draw opcode (DXYN) will read sprite data from memory, XOR it onto this buffer at coordinates (from registers VX/VY), and set VF=1 if any pixels flip (collision).
+    uint64_t display[32] = {};      // Display (64 wide x 32 tall), one bit per pixel
+                                    /*
+                                    * Chip-8 screen is 64 pixels wide by 32 tall (total 2048 pixels), and every pixel is just on or off.
+                                    * Each element is one row; bit 63 is the leftmost pixel (x = 0) and bit 0 the rightmost (x = 63), so a sprite byte lines up with "byte << 56 >> x".
+                                    * The draw opcode (DXYN) XORs a whole sprite row with one instruction and checks collision with one AND (256 bytes total instead of 8KB of RGBA words).
+                                    * Frontends that need 32-bit pixels call RenderRGBA() when they present a frame.
+                                    */
+    uint64_t dirtyRows[32] = {};    // Pixels that flipped since ClearDirty(), same layout as display
+                                    /*
+                                    * DXYN ORs in the sprite row it XORed (exactly the bits that changed), 00E0 ORs in the pixels that were on.
+                                    * GetDirtyRegions() turns this into rectangles so frontends/recorders only upload or encode what changed.
                                     */
     bool drawFlag = false;          // Set to true when draw opcode runs
                                     /*
                                     * When a draw opcode (like DXYN or 00E0 clear screen) executes in the emulation cycle, we set drawFlag = true.
-                                    * In the main loop, if true, we update the SDL window with the gfx buffer, then reset to false. This avoids redrawing every cycle.
+                                    * In the main loop, if true, we update the SDL window with the display (RenderRGBA), then reset to false. This avoids redrawing every cycle.
+                                    */
+
+    int instructionsPerFrame = 11;  // Instructions per 60Hz timer tick used by RunCycles (11 * 60 = ~660 instructions per second)
+    int frameCycles = 0;            // Instructions already run in the current frame (RunCycles/RunUntilFrame)
+    uint64_t frameCount = 0;        // Timer ticks so far (one per emulated frame)
+    bool waitingForKey = false;     // FX0A is blocking until a key is pressed
+    uint64_t keypadReads = 0;       // EX9E/EXA1/FX0A run so far (FX0A waits RunUntilFrame skips count too), lets input latency be measured to the instruction that saw the key
+    uint64_t unknownOpcodes = 0;    // Invalid opcodes executed so far (they do nothing)
+    uint16_t lastUnknownOpcode = 0; // The most recent one, for error messages
+    uint64_t skippedInstructions = 0; // Instructions RunUntilFrame fast-forwarded instead of running (idle loops, FX0A waits), same end state (counters included) as running them
+    bool skipIdleLoops = true;      // Let RunUntilFrame fast-forward idle loops (turn off to compare/benchmark)
+    bool idle = false;              // The last RunUntilFrame finished its frame early because the ROM was idling
+                                    /*
+                                    * Idle = jumping to itself (1NNN to its own address), spinning on the delay timer (FX07, 3XNN/4XNN on that value, 1NNN back to the FX07)
+                                    * or waiting for a key (FX0A). Nothing can change until the next timer tick or key press, so the rest of the frame is
+                                    * skipped in one go with the same end state as running it. Frontends can sleep until the next 60Hz tick when this is set.
                                     */
 
     uint16_t opcode = 0;            // Current opcode (2 bytes)
@@ -49,13 +112,85 @@ public:
                                     * Then, we decode it (example, via switch on opcode & 0xF000) to execute actions like jumps or adds. PC increments by 2 afterward.
                                     */
 
-    std::default_random_engine randGen;                        // RNG Engine
-	unsigned rngSeed = 0;							           // RNG Seed
-	std::uniform_int_distribution<unsigned short> randByte;    // Random byte (0-255) generator
+    Chip8Rng randGen;               // RNG for CXNN (Pcg32 by default, see Rng.h), randGen.NextByte() = random byte (0-255)
+    unsigned rngSeed = 0;           // RNG Seed
+
+    // Memory write hooks: every engine holding code compiled from memory (Chip8Jit, Chip8Aot) registers one, and NotifyMemoryWrite
+    // (and Reset/LoadROM for the pages they rebuild) calls all of them so each drops/re-checks its own copies.
+    // A list, not one slot, so attaching a second engine can't silently unhook the first one and leave it running stale code.
+    // (During RunCycles/RunUntilFrame pc may still point at the storing FX33/FX55.)
+    using CodeWriteHook = void (*)(void* context, uint16_t address, uint16_t length);
+    static constexpr int maxCodeWriteHooks = 4;
+    bool AddCodeWriteHook(CodeWriteHook hook, void* context);    // False if all maxCodeWriteHooks slots are taken (the engine must then not run compiled code)
+    void RemoveCodeWriteHook(CodeWriteHook hook, void* context);
+    struct {
+        CodeWriteHook hook;
+        void* context;
+    } codeWriteHooks[maxCodeWriteHooks] = {};
+    int codeWriteHookCount = 0;
+    Chip8Profiler* profiler = nullptr;  // Counts every executed instruction when the build defines CHIP8_PROFILE (see Profiler.h), ignored otherwise
+    const char* loadError = nullptr;    // Why the last LoadROM failed (nullptr after a successful load), the core never prints it
 
 private:
+    friend class Chip8Jit;  // Reuses Decode() and the handler ids when translating blocks
+    template <int Lanes> friend class Chip8Lanes;  // Same, for the lockstep multi-instance interpreter
+    friend class Chip8Profiler;                     // Sized by H_COUNT, names the handlers
+    friend class Chip8Fuzz;                         // Maps each executed opcode to its handler for edge coverage
+
+    // Handler ids stored in dispatchTable (index into handlerTable in Chip8.cpp)
+    enum Handler : uint8_t {
+        H_0nnn, H_1nnn, H_2nnn, H_3xnn, H_4xnn, H_5xy0, H_6xnn, H_7xnn,
+        H_8xy0, H_8xy1, H_8xy2, H_8xy3, H_8xy4, H_8xy5, H_8xy6, H_8xy7, H_8xyE,
+        H_9xy0, H_Annn, H_Bnnn, H_Cxnn, H_Dxyn, H_Ex9E, H_ExA1,
+        H_Fx07, H_Fx0A, H_Fx15, H_Fx18, H_Fx1E, H_Fx29, H_Fx33, H_Fx55, H_Fx65,
+        H_NULL,
+        H_COUNT
+    };
+
+    struct Instruction {
+        uint16_t opcode = 0;        // Raw 2-byte opcode
+        uint16_t nnn = 0;           // Lowest 12 bits (address)
+        uint8_t nn = 0;             // Lowest 8 bits (byte constant)
+        uint8_t n = 0;              // Lowest 4 bits (nibble)
+        uint8_t x = 0;              // Second nibble (VX register index)
+        uint8_t y = 0;              // Third nibble (VY register index)
+        uint8_t handler = H_NULL;
+    };
+
+    static constexpr uint8_t HandlerFor(uint16_t opcode);           // Nested switch decode tree, only run at compile time to fill dispatchTable (and by CycleSwitch)
+    static constexpr std::array<uint8_t, 0x10000> BuildDispatchTable();
+    static const std::array<uint8_t, 0x10000> dispatchTable;         // Handler id for every possible 16-bit opcode (H_NULL for invalid encodings)
+    static Instruction Operands(uint16_t opcode, uint8_t handler);  // Splits an opcode into its x/y/n/nn/nnn operands (JIT/lanes translation)
+    static Instruction Decode(uint16_t opcode);                     // Operands + handler looked up in dispatchTable
+    uint16_t Execute(uint16_t at);                                  // Fetch + execute the instruction at `at`, returns the next pc (body of the Run* loops)
+    void Step();                                                    // pc = Execute(pc) (body of Cycle)
+    int SkipIdleLoop(uint16_t jumpAddress, int remaining);          // After the 1NNN at jumpAddress: instructions of an idle loop that can be skipped (0 = not idle)
+    static void (Chip8::* const handlerTable[H_COUNT])(); // Handler id -> OP_* member function
+
+    std::shared_ptr<const RomFile> romImage;    // What the last LoadROM loaded (nullptr before the first one)
+    std::shared_ptr<RomFile> bufferImage;       // The image LoadROM(span) copies into, refilled in place while nothing else holds it
+    uint64_t dirtyPages = 0;                    // Bit n = memory[n*64 .. n*64+63] written since LoadROM/Reset
+                                                /*
+                                                * Every write to memory already goes through NotifyMemoryWrite (FX33, FX55, LoadState, the AOT helpers),
+                                                * so that's where pages are marked. A typical episode only stores into a page or two, so Reset() rebuilds
+                                                * 64-128 bytes instead of 4KB, from what memory is made of after LoadROM: zeros, fontSet and romImage.
+                                                * No private copy of the 4KB is kept (romImage is shared by every instance running that ROM).
+                                                */
+    void RestorePages();                        // Rebuilds the dirty pages from zeros + fontSet + romImage, clears dirtyPages
+    void CallCodeWriteHooks(uint16_t address, uint16_t length) {
+        for (int i = 0; i < codeWriteHookCount; ++i) {
+            codeWriteHooks[i].hook(codeWriteHooks[i].context, address, length);
+        }
+    }
+    // Operands of the opcode being executed, handlers take them straight from opcode (a shift and a mask, nothing is cached per address)
+    uint8_t X() const { return (opcode >> 8) & 0x0F; }     // Second nibble (VX register index)
+    uint8_t Y() const { return (opcode >> 4) & 0x0F; }     // Third nibble (VY register index)
+    uint8_t N() const { return opcode & 0x000F; }          // Lowest 4 bits (nibble)
+    uint8_t NN() const { return opcode & 0x00FF; }         // Lowest 8 bits (byte constant)
+    uint16_t NNN() const { return opcode & 0x0FFF; }       // Lowest 12 bits (address)
+
     // https://johnearnest.github.io/Octo/docs/chip8ref.pdf
-    // Opcode handlers (placeholders)
+    // Opcode handlers
     void OP_0nnn();
     void OP_1nnn();
     void OP_2nnn();
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "Chip8.h"
+
+// Ahead-of-time compiled ROMs (see tools/Aot.cpp, which generates the code this runs)
+/*
+* chip8-aot walks a ROM's control flow from 0x200 and writes a C++ file with one function per basic block, working directly on
+* the Chip8's public state (registers, index, pc, stack, timers, display). That file is compiled together with this runtime and
+* the rest of the core into a native binary for one ROM: no fetch, no decode and no dispatch, just the C++ compiler's code.
+* Chip8Aot::Run() looks up the block at pc and calls it; anything that wasn't compiled falls back to Chip8::Cycle():
+* - addresses the static walk couldn't see (BNNN targets, code reached through data),
+* - blocks whose bytes no longer match the ROM (self-modifying code, checked again on every write through a code write hook),
+* - blocks that wouldn't fit in the instruction count Run() was asked for,
+* - everything, if the chip had no free code write hook slot left when this was attached.
+* The results are exactly the same as running the interpreter (the profiler doesn't see compiled blocks).
+*/
+struct Chip8AotBlock {
+    uint16_t address;               // First instruction
+    uint16_t bytes;                 // ROM bytes the block was compiled from, starting at address
+    uint16_t instructions;          // Instructions executed by one call
+    void (*fn)(Chip8& chip);
+};
+
+struct Chip8AotProgram {
+    const char* name;               // ROM file name
+    const uint8_t* rom;             // ROM image the blocks were compiled from (loaded at 0x200)
+    size_t romSize;
+    const Chip8AotBlock* blocks;
+    size_t blockCount;
+};
+
+extern const Chip8AotProgram chip8AotProgram;  // Defined by the generated file
+
+class Chip8Aot {
+public:
+    Chip8Aot(Chip8& chip, const Chip8AotProgram& program);
+    ~Chip8Aot();
+    Chip8Aot(const Chip8Aot&) = delete;
+    Chip8Aot& operator=(const Chip8Aot&) = delete;
+
+    int Run(int cycles);                                // Executes exactly `cycles` instructions (same result as calling chip.Cycle() that many times), returns the count
+    void Invalidate(uint16_t address, uint16_t length); // Re-checks every block that overlaps memory[address..address+length) against the ROM
+
+    size_t ActiveBlocks() const;                        // Blocks whose code still matches memory
+
+private:
+    static void CodeWriteHook(void* context, uint16_t address, uint16_t length);
+
+    Chip8& chip;
+    const Chip8AotProgram& program;
+    uint16_t maxBlockBytes = 0;
+    const Chip8AotBlock* compiled[4096] = {};   // Every generated block by start address
+    const Chip8AotBlock* blocks[4096] = {};     // Same, nullptr while memory differs from what it was compiled from
+};
+
+// Helpers called by the generated code for the longer opcodes (same behaviour as the matching Chip8::OP_* handlers)
+namespace chip8aot {
+
+// DXYN
+inline void Draw(Chip8& c, uint8_t x, uint8_t y, uint8_t n) {
+    uint8_t xPos = c.registers[x] % 64;
+    uint8_t yPos = c.registers[y] % 32;
+    uint64_t collision = 0;
+    for (int row = 0; row < n && yPos + row < 32; ++row) {
+        uint64_t spriteRow = (static_cast<uint64_t>(c.memory[(c.index + row) & 0x0FFF]) << 56) >> xPos;
+        collision |= c.display[yPos + row] & spriteRow;
+        c.display[yPos + row] ^= spriteRow;
+        c.dirtyRows[yPos + row] |= spriteRow;
+    }
+    c.registers[0xF] = collision ? 1 : 0;
+    c.drawFlag = true;
+}
+
+// 00E0
+inline void Clear(Chip8& c) {
+    for (int row = 0; row < 32; ++row) {
+        c.dirtyRows[row] |= c.display[row];
+        c.display[row] = 0;
+    }
+    c.drawFlag = true;
+}
+
+// FX0A, false (and pc back on the FX0A) while no key is down
+inline bool WaitKey(Chip8& c, uint8_t x, uint16_t address) {
+    ++c.keypadReads;
+    for (uint8_t key = 0; key < 16; ++key) {
+        if (c.keypad[key]) {
+            c.registers[x] = key;
+            c.waitingForKey = false;
+            return true;
+        }
+    }
+    c.pc = address;
+    c.waitingForKey = true;
+    return false;
+}
+
+// FX33
+inline void StoreBcd(Chip8& c, uint8_t x) {
+    uint8_t value = c.registers[x];
+    c.memory[c.index & 0x0FFF] = value / 100;
+    c.memory[(c.index + 1) & 0x0FFF] = (value / 10) % 10;
+    c.memory[(c.index + 2) & 0x0FFF] = value % 10;
+    c.NotifyMemoryWrite(c.index, 3);
+}
+
+// FX55
+inline void StoreRegisters(Chip8& c, uint8_t x) {
+    for (int i = 0; i <= x; ++i) {
+        c.memory[(c.index + i) & 0x0FFF] = c.registers[i];
+    }
+    c.NotifyMemoryWrite(c.index, x + 1);
+}
+
+// FX65
+inline void LoadRegisters(Chip8& c, uint8_t x) {
+    for (int i = 0; i <= x; ++i) {
+        c.registers[i] = c.memory[(c.index + i) & 0x0FFF];
+    }
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include "Chip8.h"
+
+// Runs fuzzer inputs as ROMs and records which (PC, handler) -> (PC, handler) transitions they reach
+/*
+* One Chip8Fuzz keeps one Chip8 for the whole fuzzing session. Every input goes through the same steps, so the same bytes always
+* give the same run (and the same coverage), whatever ran before:
+* - the input is loaded with LoadROM(span) (no file I/O, inputs over 3584 bytes are cut), which only rebuilds the memory pages
+*   the last input wrote or covered
+* - Reset(): clears the registers/display (see Chip8::Reset)
+* - a bounded number of Cycle() calls with a fixed seed, the timers ticking every instructionsPerFrame instructions and a
+*   fixed keypad pattern (key n held during frames 4n..4n+3, repeating) so FX0A/EX9E/EXA1 paths can be reached.
+*
+* Coverage is AFL style: every executed instruction is a location ((PC << 6 | handler) hashed to 16 bits) and
+* map[location ^ previous >> 1] is incremented, so the map counts edges between instructions, not just instructions.
+* The map can be the fuzzer's own counters (libFuzzer extra counters, see tools/Fuzz.cpp) or the one Chip8Fuzz owns.
+*
+* After each run the machine is checked (sp within the stack); a broken invariant aborts so the fuzzer keeps the input.
+*/
+class Chip8Fuzz {
+public:
+    static constexpr size_t mapSize = 1 << 16;
+    static constexpr int defaultCycles = 1000;  // ~90 frames at 11 instructions per frame
+
+    explicit Chip8Fuzz(uint8_t* coverageMap = nullptr, int cycles = defaultCycles, unsigned seed = 1); // coverageMap: mapSize counters, nullptr = own map
+    Chip8Fuzz(const Chip8Fuzz&) = delete;
+    Chip8Fuzz& operator=(const Chip8Fuzz&) = delete;
+
+    int Run(std::span<const uint8_t> input);    // One input, returns the instructions executed
+    size_t EdgesHit() const;                    // Non-zero counters in the map
+    void ClearMap();
+
+    const uint8_t* Map() const { return map; }
+    const Chip8& Machine() const { return *chip; }  // State at the end of the last Run (for reporting)
+
+private:
+    std::unique_ptr<Chip8> chip;
+    std::unique_ptr<uint8_t[]> ownMap;
+    uint8_t* map;
+    int cycles;
+    unsigned seed;
+};
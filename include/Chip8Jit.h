@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "Chip8.h"
+
+// Dynamic recompiler for the Chip8 core (x86-64 only)
+/*
+* Straight-line runs of CHIP-8 code (basic blocks) are translated once into native x86-64 code and cached by their start address.
+* A block ends at the first instruction that can change the control flow (1NNN, 2NNN, 00EE, BNNN, skips, FX0A) or write memory (FX33, FX55).
+* Simple register/timer opcodes are emitted as native instructions; everything else (DXYN, CXNN, 00E0, FX65, ...) calls back into Chip8::Cycle(),
+* so the results are exactly the same as running the interpreter.
+* On other architectures (or if executable memory can't be allocated, or the chip has no free code write hook slot) Run() just calls Cycle().
+*/
+class Chip8Jit {
+public:
+    explicit Chip8Jit(Chip8& chip);
+    ~Chip8Jit();
+    Chip8Jit(const Chip8Jit&) = delete;
+    Chip8Jit& operator=(const Chip8Jit&) = delete;
+
+    int Run(int cycles);                                // Executes exactly `cycles` instructions (same result as calling chip.Cycle() that many times), returns the count
+    void Invalidate(uint16_t address, uint16_t length); // Drops every block that overlaps memory[address..address+length)
+    void Flush();                                       // Drops all blocks and rewinds the code buffer
+    bool IsAvailable() const { return code != nullptr; }
+
+private:
+    using BlockFn = void (*)(Chip8* chip);
+
+    struct Block {
+        BlockFn fn = nullptr;       // Native code (nullptr = not compiled)
+        uint16_t bytes = 0;         // CHIP-8 bytes covered, starting at the block address
+        uint16_t instructions = 0;  // Number of CHIP-8 instructions executed by one call
+    };
+
+    static constexpr size_t codeSize = 1 << 20;   // 1MB of executable memory, flushed when full
+    static constexpr int maxBlockInstructions = 64;
+
+    const Block* Compile(uint16_t address);
+    void FreeCode();
+    static void CodeWriteHook(void* context, uint16_t address, uint16_t length);
+
+    Chip8& chip;
+    uint8_t* code = nullptr;        // Executable memory
+    size_t codeUsed = 0;
+    Block blocks[4096] = {};        // Indexed by start address
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include "Chip8.h"
+
+// Lockstep interpreter for Lanes (8 or 16) CHIP-8 machines at once, structure-of-arrays layout
+/*
+* Every field Chip8 keeps per object becomes an array with one entry per lane (registers[x][lane], pc[lane], ...),
+* so the same instruction can be applied to all lanes with plain loops the compiler turns into SSE/AVX2/AVX-512 code.
+* Each Step() fetches one opcode per lane; lanes that fetched the same opcode run together, the others are masked out
+* and get their own pass. Register/flag/skip/jump opcodes are branch-free blends across lanes; opcodes that index memory,
+* the stack, the keypad or the RNG per lane (DXYN, FX33, FX55, FX65, CXNN, 2NNN, 00EE, ...) loop over the active lanes.
+* The result of Run(n) on a lane is exactly the state of a Chip8 that ran Cycle() n times (use Store() to compare).
+*/
+template <int Lanes>
+class Chip8Lanes {
+    static_assert(Lanes > 0 && Lanes <= 32, "lane mask is a uint32_t");
+
+public:
+    void Load(int lane, const Chip8& chip);     // Copies a machine into a lane
+    void Store(int lane, Chip8& chip) const;    // Copies a lane back into a Chip8 (JIT/AOT code and Reset() are told memory changed)
+    void Step();                                // One instruction on every lane (same as Cycle())
+    void Run(int cycles);
+    void TickTimers();                          // Chip8::TickTimers() on every lane
+
+    alignas(64) uint8_t registers[16][Lanes] = {};
+    alignas(64) uint16_t index[Lanes] = {};
+    alignas(64) uint16_t pc[Lanes] = {};
+    alignas(64) uint16_t opcode[Lanes] = {};
+    alignas(64) uint8_t sp[Lanes] = {};
+    alignas(64) uint8_t delayTimer[Lanes] = {};
+    alignas(64) uint8_t soundTimer[Lanes] = {};
+    alignas(64) uint8_t drawFlag[Lanes] = {};
+    alignas(64) uint8_t waitingForKey[Lanes] = {};
+    uint64_t frameCount[Lanes] = {};
+    uint64_t keypadReads[Lanes] = {};           // Same counters as Chip8, so Store() gives exactly the machine n Cycle() calls would
+    uint64_t unknownOpcodes[Lanes] = {};
+    uint16_t lastUnknownOpcode[Lanes] = {};
+    uint16_t stack[Lanes][16] = {};             // Indexed by each lane's own sp, so kept per lane
+    uint8_t keypad[Lanes][16] = {};
+    uint64_t display[Lanes][32] = {};
+    uint64_t dirtyRows[Lanes][32] = {};
+    uint8_t memory[Lanes][4096] = {};
+    Chip8Rng randGen[Lanes];
+
+private:
+    void Execute(uint16_t op, uint32_t group);  // Runs one opcode on the lanes set in group
+};
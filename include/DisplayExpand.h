@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+// Bitplane -> RGBA32 expansion for presenting a Chip8 display
+/*
+* Takes the 32 bit-packed rows of Chip8::display (bit 63 = leftmost pixel) and writes (64 * scale) x (32 * scale) RGBA32 pixels,
+* e.g. straight into a locked SDL streaming texture or a video encoder frame.
+* The SSE2/AVX2 kernels are picked at run time from what the CPU supports, with a plain C++ loop as fallback.
+*/
+enum class ExpandPath { Scalar, SSE2, AVX2 };
+
+void ExpandDisplay(const uint64_t rows[32], uint32_t* pixels, int pitch, uint32_t onColor, uint32_t offColor, int scale); // scale >= 1, pitch = pixels per output line (>= 64 * scale)
+ExpandPath GetExpandPath();             // Kernel ExpandDisplay is using
+bool SetExpandPath(ExpandPath path);    // Forces a kernel (benchmarks/comparisons), false if the CPU or build doesn't support it
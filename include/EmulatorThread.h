@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "Chip8.h"
+#include "TripleBuffer.h"
+#include "SpscQueue.h"
+#include "RunAhead.h"
+
+// Runs a Chip8 on its own thread at 60 frames per second and hands finished frames to the render thread
+/*
+* The emulation thread runs one frame (RunUntilFrame until the timers tick), copies the display into the back slot of a
+* TripleBuffer and publishes it, then sleeps until the next 60Hz tick. The render thread calls LatestFrame() whenever it wants
+* to draw: it gets the newest complete frame without ever blocking, so slow vsync/texture uploads can't stall emulation
+* and an emulation spike only means the renderer shows the previous frame once more.
+*
+* Input: the thread polling SDL events pushes each key change with PushKey(), which timestamps it and puts it on a lock-free
+* SPSC queue; only the emulation thread ever writes chip.keypad. At the start of a frame it takes every queued event and places it
+* at the instruction matching when it happened within the previous 1/60s (e.g. an event halfway through that interval is applied
+* after instructionsPerFrame / 2 instructions), so the ROM sees key changes at the same instruction boundaries however the threads
+* happen to be scheduled. Don't touch the Chip8 from other threads between Start() and Stop().
+*
+* Input latency is measured from the event's timestamp to the first EX9E/EXA1/FX0A that runs after the key was applied
+* (emulated time of that instruction), see GetInputLatency(). With runAheadFrames > 0 the published display comes from RunAhead
+* (that many frames into the future with the current keys), which hides the ROM's own reaction lag on top of that.
+*
+* Typical SDL loop:
+*   EmulatorThread emulation(chip);
+*   emulation.Start();
+*   while (running) {
+*       // poll events: emulation.PushKey(key, down)
+*       const EmulatorThread::Frame* frame;
+*       if (emulation.LatestFrame(frame)) { ExpandDisplay(frame->display, pixels, ...); present }
+*   }
+*   emulation.Stop();
+*/
+class EmulatorThread {
+public:
+    struct Frame {
+        uint64_t display[32] = {};  // Chip8::display at the end of the frame
+        uint64_t frameCount = 0;    // Chip8::frameCount after the frame
+        bool soundOn = false;       // soundTimer > 0
+        bool idle = false;          // The ROM spent the end of the frame idling (Chip8::idle)
+        uint32_t runAheadMicroseconds = 0; // Extra CPU time this frame spent running ahead (0 when it's off)
+    };
+
+    explicit EmulatorThread(Chip8& chip, int runAheadFrames = 0);
+    ~EmulatorThread();              // Stops the thread
+    EmulatorThread(const EmulatorThread&) = delete;
+    EmulatorThread& operator=(const EmulatorThread&) = delete;
+
+    void Start();
+    void Stop();                    // Finishes the current frame and joins, the Chip8 can be used again afterwards
+
+    struct InputLatency {
+        uint64_t samples = 0;       // Key events that were seen by the ROM
+        double meanMs = 0;
+        double maxMs = 0;
+    };
+
+    bool PushKey(uint8_t key, bool pressed);  // Input thread (only one). False if the queue is full
+    InputLatency GetInputLatency() const;
+    bool LatestFrame(const Frame*& frame); // Render thread: true (and frame set) if a newer frame was published since the last call
+    uint64_t LateFrames() const { return lateFrames.load(std::memory_order_relaxed); } // Frames that finished after their 60Hz deadline
+
+private:
+    struct KeyEvent {
+        int64_t time = 0;           // steady_clock ticks when PushKey was called
+        uint8_t key = 0;
+        bool pressed = false;
+    };
+    struct PlacedEvent {
+        int cycle = 0;              // Instruction within the frame to apply it at
+        KeyEvent event;
+    };
+    static constexpr int maxEventsPerFrame = 64;
+
+    void Loop();
+    void RunFrame(int64_t frameStart, int64_t frameTicks, PlacedEvent* events, int count);
+
+    Chip8& chip;
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    std::atomic<uint64_t> lateFrames{ 0 };
+    TripleBuffer<Frame> frames;
+    SpscQueue<KeyEvent, 256> input;
+    RunAhead runAhead;
+
+    // Latency of the oldest key event the ROM hasn't read yet (emulation thread only)
+    bool latencyPending = false;
+    int64_t latencyEventTime = 0;
+    uint64_t latencyFrame = 0;
+    std::atomic<uint64_t> latencySamples{ 0 };
+    std::atomic<int64_t> latencyTotal{ 0 };         // steady_clock ticks
+    std::atomic<int64_t> latencyMax{ 0 };
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Chip8.h"
+#include "RomCache.h"
+
+// Runs many Chip8 instances (ROM + seed + input script each) across all cores
+/*
+* Every job is advanced one emulated frame per task. A worker pushes the job back onto its own deque after each frame,
+* and idle workers steal from the other end of someone else's deque, so a few long jobs can't leave cores idle.
+* ROM files are read once through RomCache and shared between jobs (and between farms) as read-only images.
+* Each job writes its result into its own slot, so no locks are taken on the results.
+*/
+struct FarmInput {
+    uint64_t frame;     // Applied at the start of this frame
+    uint8_t key;        // 0-F
+    bool pressed;
+};
+
+struct FarmJob {
+    RomImage rom;
+    unsigned seed = 0;
+    uint64_t frames = 600;          // 0 = just load the ROM (the result is the machine before its first frame)
+    int instructionsPerFrame = 11;
+    std::vector<FarmInput> input;   // Sorted by frame
+};
+
+struct FarmResult {
+    bool loaded = false;            // False if the ROM didn't fit in memory
+    uint64_t frames = 0;
+    uint64_t instructions = 0;
+    uint16_t pc = 0;
+    uint16_t index = 0;
+    uint8_t registers[16] = {};
+    uint64_t displayHash = 0;
+};
+
+class Farm {
+public:
+    explicit Farm(unsigned threads = 0);  // 0 = one worker per hardware thread
+    ~Farm();
+    Farm(const Farm&) = delete;
+    Farm& operator=(const Farm&) = delete;
+
+    static RomImage LoadRomImage(const std::string& filename);  // RomCache::Shared().Load, prints the failure (nullptr on failure)
+
+    size_t Add(FarmJob job);        // Returns the job id (index into Results())
+    void Run();                     // Runs every added job to completion, blocks until done
+    const std::vector<FarmResult>& Results() const { return results; }
+    unsigned Threads() const { return threadCount; }
+
+private:
+    class WorkDeque;
+
+    struct Instance {
+        std::unique_ptr<Chip8> chip;
+        size_t nextInput = 0;
+        uint64_t instructions = 0;
+    };
+
+    void Worker(unsigned self);
+    bool RunFrame(size_t id);       // Returns true when the job is finished
+    void Finish(size_t id);         // Copies the instance's state into results[id]
+
+    unsigned threadCount;
+    std::vector<FarmJob> jobs;
+    std::vector<Instance> instances;
+    std::vector<FarmResult> results;
+    std::vector<std::unique_ptr<WorkDeque>> deques;
+    std::atomic<size_t> remaining{ 0 };
+};
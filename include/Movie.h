@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "Chip8.h"
+
+// Input movies: everything needed to reproduce a run exactly (RNG seed, speed, keypad transitions) plus framebuffer hashes to check it against
+/*
+* A key transition is stored with the frame and the instruction inside that frame (frameCycles) where it happened,
+* so replaying it presses/releases the key between exactly the same two instructions as the original run.
+* The display hash (Chip8::DisplayHash) is stored at the end of every frame; the replayer compares them as it goes.
+*
+* File format (text, one record per line):
+*   chip8-movie 1
+*   seed <rngSeed>
+*   ipf <instructionsPerFrame>
+*   frames <frames recorded>
+*   key <frame> <cycle> <key 0-F> <down|up>
+*   hash <frame> <hex hash>
+*/
+struct MovieEvent {
+    uint64_t frame;     // Chip8::frameCount when the key changed
+    uint16_t cycle;     // Chip8::frameCycles when the key changed
+    uint8_t key;        // 0-F
+    bool pressed;
+};
+
+struct MovieHash {
+    uint64_t frame;     // Display hash once this many frames had run
+    uint64_t hash;
+};
+
+struct Movie {
+    unsigned seed = 0;
+    int instructionsPerFrame = 11;
+    uint64_t frames = 0;
+    std::vector<MovieEvent> events;     // In the order they happened
+    std::vector<MovieHash> hashes;      // One per frame, in frame order
+
+    bool Save(const std::string& filename) const;
+    bool Load(const std::string& filename);
+};
+
+// Records a running Chip8 into a Movie
+/*
+* Call Update() right before each RunUntilFrame/RunCycles/Cycle call (after the frontend wrote the keypad) and once more at the end:
+* it logs the keys that changed since the last call and the display hash of every frame that just ended.
+* The Chip8 must have been created with a fixed seed (Chip8(seed)), not have run yet, and be run at its own instructionsPerFrame.
+*/
+class MovieRecorder {
+public:
+    explicit MovieRecorder(const Chip8& chip);
+    void Update(const Chip8& chip);
+    const Movie& GetMovie() const { return movie; }
+
+private:
+    Movie movie;
+    uint8_t keys[16] = {};
+};
+
+struct ReplayResult {
+    bool loaded = false;            // ROM fit in memory
+    uint64_t frames = 0;
+    uint64_t instructions = 0;
+    size_t hashesChecked = 0;
+    size_t mismatches = 0;
+    uint64_t firstMismatch = 0;     // Frame of the first wrong hash (only valid if mismatches > 0)
+    uint64_t displayHash = 0;       // At the end of the replay
+};
+
+// Replays a movie headless as fast as possible on a fresh Chip8 and checks every recorded hash
+ReplayResult ReplayMovie(std::span<const uint8_t> rom, const Movie& movie);
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Chip8.h"
+
+// Execution profiler: how many times each opcode handler and each program address ran
+/*
+* Only compiled in when the build defines CHIP8_PROFILE; otherwise Chip8::Step() has no profiling code at all and Enabled() is false.
+* When it is compiled in, attach a profiler to a Chip8 (chip.profiler = &profiler) and every instruction run through
+* Cycle/RunCycles/RunUntilFrame adds one to its handler and address counters (two increments, no allocation).
+* RunThreaded, the JIT and fast-forwarded idle loops don't go through Step() and aren't counted.
+*
+* Results:
+* - WriteJson: totals per handler and per address (sorted, most executed first).
+* - WriteCollapsed: "name;handler;address count" lines, the input format of flamegraph.pl / speedscope / inferno.
+*   Profiles of several ROMs (with different names) can be concatenated into one flame graph.
+*/
+class Chip8Profiler {
+public:
+    explicit Chip8Profiler(std::string name = "chip8");
+
+    static constexpr bool Enabled() {
+#ifdef CHIP8_PROFILE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void Count(uint16_t address, uint8_t handler) {
+        ++handlerCounts[handler];
+        ++addressCounts[address & 0x0FFF];
+        addressHandlers[address & 0x0FFF] = handler;
+    }
+    void Reset();
+    void Merge(const Chip8Profiler& other);     // Adds another run of the same ROM (e.g. one per farm job)
+    uint64_t Instructions() const;
+
+    bool WriteJson(const std::string& filename) const;
+    bool WriteCollapsed(const std::string& filename) const;
+    static const char* HandlerName(uint8_t handler);    // "OP_Dxyn", ...
+
+    std::string name;                       // First frame of every collapsed stack (ROM name)
+    uint64_t handlerCounts[Chip8::H_COUNT] = {};
+    uint64_t addressCounts[4096] = {};
+    uint8_t addressHandlers[4096] = {};     // Handler last run at each address (for labelling)
+};
+
+// Quoted JSON string (ROM names and paths can contain quotes, backslashes (Windows) or control characters).
+// Used by the profile output and by the tools that print JSON (chip8-headless, the AOT runner).
+std::string JsonString(const std::string& text);
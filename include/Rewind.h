@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Chip8.h"
+
+// Rewind history for one Chip8: a fixed-size ring of compressed save states, one per pushed frame
+/*
+* Each frame is stored as the XOR of its save state with the previous frame's, run-length encoded (only the bytes that changed:
+* a few registers, the frame counters and the display rows that were drawn to), so a frame usually costs tens of bytes instead of 4KB+.
+* Stepping back just XORs the newest delta into the current state again (a ^ b ^ b = a) and loads it, no matter how long the history is.
+* Every keyframeInterval frames the full state is stored too (RLE), so Seek() can jump far back from the nearest keyframe
+* instead of undoing every frame in between.
+* All memory is allocated in the constructor, bufferBytes covers both the ring and the frame records (1/8 of it);
+* when either is full the oldest frames are dropped.
+*/
+class Rewind {
+public:
+    explicit Rewind(size_t bufferBytes = 4 << 20, int keyframeInterval = 60);
+
+    void Push(const Chip8& chip);       // Records the machine as it is now (call once per frame)
+    bool StepBack(Chip8& chip);         // Restores the frame before the newest one and forgets the newest, false if there's nothing to go back to
+    int Seek(Chip8& chip, int frames);  // Goes back `frames` frames at once (clamped to the history), returns how many it went back
+    void Clear();
+
+    size_t Frames() const { return count; }         // Frames recorded (StepBack works while this is > 1)
+    size_t BytesUsed() const;                       // Ring bytes taken by the recorded frames
+
+private:
+    struct Entry {
+        uint64_t start = 0;         // Position in the ring, counted from the first byte ever written (offset = start % ring size)
+        uint32_t deltaSize = 0;     // RLE XOR delta against the previous frame
+        uint32_t keySize = 0;       // RLE full state after the delta (0 = not a keyframe)
+    };
+
+    static size_t EncodeRuns(const uint8_t* a, const uint8_t* b, uint8_t* out); // RLE of a ^ b (b = nullptr encodes a itself), returns the encoded size
+    static void ApplyRuns(const uint8_t* runs, size_t size, uint8_t* state);    // XORs encoded runs into state
+    Entry& At(size_t i) { return entries[(first + i) % entries.size()]; }
+    const uint8_t* Data(uint64_t position) const { return ring.data() + position % ring.size(); }
+
+    std::vector<uint8_t> ring;
+    std::vector<Entry> entries;     // Ring of frame records, oldest at `first`
+    size_t first = 0;
+    size_t count = 0;
+    uint64_t head = 0;              // Where the next frame is written (same numbering as Entry::start)
+    int keyframeInterval;
+    int sinceKeyframe = 0;
+
+    std::vector<uint8_t> current;   // Save state of the newest frame
+    std::vector<uint8_t> scratch;   // New save state / encoded delta while pushing
+    std::vector<uint8_t> encoded;
+};
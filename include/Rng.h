@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Random byte generators for CXNN
+/*
+* std::default_random_engine is a different algorithm in every standard library (minstd_rand0 in libstdc++, mt19937 in MSVC),
+* so the same seed gave different games on different compilers, and its state couldn't be saved portably.
+* These are small fixed algorithms: same seed = same bytes everywhere, the state is a couple of integers,
+* and getting a byte is a few arithmetic instructions (no library call).
+*
+* A generator ("RNG policy") is any trivially copyable struct with:
+*   void Seed(uint32_t seed);
+*   uint8_t NextByte();
+*   static constexpr uint8_t id;              // Written into save states, different for every policy
+*   static constexpr size_t stateBytes;       // Size of the serialized state
+*   void Save(uint8_t* out) const;            // stateBytes bytes, little-endian
+*   void Load(const uint8_t* in);
+*
+* Chip8 uses Chip8Rng, which is Pcg32 unless the build defines CHIP8_RNG as another policy (e.g. /DCHIP8_RNG=XorShift32).
+*/
+
+// PCG-XSH-RR 32 (https://www.pcg-random.org), 64-bit LCG state, fixed stream
+struct Pcg32 {
+    static constexpr uint8_t id = 1;
+    static constexpr size_t stateBytes = 8;
+    static constexpr uint64_t multiplier = 6364136223846793005ull;
+    static constexpr uint64_t increment = 1442695040888963407ull;
+
+    uint64_t state = 0;
+
+    void Seed(uint32_t seed) {
+        // Same as pcg32_srandom_r: one step from 0, add the seed, one more step
+        state = 0;
+        Next();
+        state += seed;
+        Next();
+    }
+    uint32_t Next() {
+        uint64_t old = state;
+        state = old * multiplier + increment;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rot = static_cast<uint32_t>(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+    uint8_t NextByte() {
+        return static_cast<uint8_t>(Next() >> 24);  // Top bits are the best ones
+    }
+    void Save(uint8_t* out) const {
+        for (size_t i = 0; i < stateBytes; ++i) {
+            out[i] = static_cast<uint8_t>(state >> (i * 8));
+        }
+    }
+    void Load(const uint8_t* in) {
+        state = 0;
+        for (size_t i = 0; i < stateBytes; ++i) {
+            state |= static_cast<uint64_t>(in[i]) << (i * 8);
+        }
+    }
+    bool operator==(const Pcg32&) const = default;
+};
+
+// Marsaglia xorshift32 (13, 17, 5): smaller and a bit faster than Pcg32, weaker low bits (only the top byte is used)
+struct XorShift32 {
+    static constexpr uint8_t id = 2;
+    static constexpr size_t stateBytes = 4;
+
+    uint32_t state = 0x9E3779B9;
+
+    void Seed(uint32_t seed) {
+        // Mix the seed (nearby seeds would otherwise start with nearly the same bits) and never use 0, xorshift would stay at 0 forever
+        uint32_t mixed = (seed ^ 0x9E3779B9) * 0x85EBCA6B;
+        mixed ^= mixed >> 13;
+        state = mixed ? mixed : 0x9E3779B9;
+    }
+    uint32_t Next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    uint8_t NextByte() {
+        return static_cast<uint8_t>(Next() >> 24);
+    }
+    void Save(uint8_t* out) const {
+        for (size_t i = 0; i < stateBytes; ++i) {
+            out[i] = static_cast<uint8_t>(state >> (i * 8));
+        }
+    }
+    void Load(const uint8_t* in) {
+        state = 0;
+        for (size_t i = 0; i < stateBytes; ++i) {
+            state |= static_cast<uint32_t>(in[i]) << (i * 8);
+        }
+    }
+    bool operator==(const XorShift32&) const = default;
+};
+
+#ifndef CHIP8_RNG
+#define CHIP8_RNG Pcg32
+#endif
+using Chip8Rng = CHIP8_RNG;
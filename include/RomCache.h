@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One ROM file read into an immutable buffer, shared by every instance that loads it
+/*
+* Open() checks the file size first, then maps the file read-only (mmap / MapViewOfFile, no stream), copies it into the image's
+* own buffer, unmaps it and hashes it once. This is a copy, not a zero-copy view of the file: at most 3.5KB (bigger files are
+* refused before anything is read), and nothing keeps pointing into the file afterwards, so a ROM that is truncated or rewritten
+* on disk can't crash (SIGBUS) or silently change an image that is already loaded or cached.
+* Platforms without a mapping API read the file with a stream instead.
+* Images are shared through RomImage (shared_ptr), any number of instances can LoadROM from the same image without extra reads.
+*/
+class RomFile {
+public:
+    static constexpr size_t maxSize = 4096 - 0x200;    // Biggest ROM that fits in memory from 0x200
+
+    static std::shared_ptr<const RomFile> Open(const std::string& filename, const char** error = nullptr); // nullptr if the file can't be read or is over maxSize (*error says which)
+    static std::shared_ptr<RomFile> FromBytes(std::vector<uint8_t> bytes, std::string name = "");           // Image of a buffer (generated ROMs, tests), any size
+    void Assign(std::span<const uint8_t> bytes);        // Replaces the bytes in place, reusing the buffer: only for an image nobody else holds
+                                                        // (Chip8::LoadROM(span) refills its own private image this way)
+    RomFile(const RomFile&) = delete;
+    RomFile& operator=(const RomFile&) = delete;
+
+    std::span<const uint8_t> Bytes() const { return { data, size }; }
+    uint64_t Hash() const { return hash; }                  // FNV-1a of the bytes, same ROM = same hash whatever the file name
+    const std::string& Name() const { return name; }        // Path it was opened from
+
+private:
+    RomFile() = default;
+    static uint64_t HashBytes(const uint8_t* bytes, size_t count);
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    uint64_t hash = 0;
+    std::string name;
+    std::vector<uint8_t> owned;     // The bytes (data points here)
+};
+
+using RomImage = std::shared_ptr<const RomFile>;
+
+// Process-wide ROM images by file name (and by content, so two paths to the same ROM share one image)
+/*
+* The first Load() of a file reads and hashes it, every later Load() of that name just returns the same image, so thousands of
+* instances (farm jobs, fuzzing/search episodes resetting over and over) pay for one open, one read and one hash in total.
+* Thread-safe: one mutex around the lookups, which only happen when a ROM is picked, never per instruction or per reset.
+* Images stay cached until Clear() (they're private copies, so later changes to the file aren't seen: Clear() to reload it).
+*/
+class RomCache {
+public:
+    static RomCache& Shared();
+
+    RomImage Load(const std::string& filename);     // nullptr if the file can't be opened
+    void Clear();
+    size_t Size() const;                            // Distinct images held
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, RomImage> byName;
+    std::unordered_map<uint64_t, RomImage> byHash;
+};
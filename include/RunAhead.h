@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Chip8.h"
+
+// Run-ahead: shows the frame the ROM will draw `frames` frames from now with the keys held right now
+/*
+* CHIP-8 games poll the keypad (EX9E/EXA1) once per game loop and draw the result on a later frame, so a key press usually
+* shows up on screen a frame or two after the frame it landed in. After every real frame Run() saves the machine, runs `frames`
+* more frames with the current keypad, keeps that display, and loads the save back: the emulated machine is exactly where it
+* was, but the frontend presents a frame that already reacts to the input.
+* A save + load is a few KB of copying (LoadState only copies the 64-byte pages that changed and marks them dirty, see NotifyMemoryWrite), so the cost is mostly
+* the extra emulated frames; LastMicroseconds()/MeanMicroseconds() report it per real frame.
+* Wrong guesses fix themselves: the next real frame runs with the real input and run-ahead starts again from there.
+*/
+class RunAhead {
+public:
+    explicit RunAhead(int frames = 1);
+
+    void Run(Chip8& chip);          // Call after each real frame (same keypad the next frame will use), chip is left untouched
+    const uint64_t* Display() const { return display; } // Display of the run-ahead frame, same layout as Chip8::display
+    bool SoundOn() const { return soundOn; }
+
+    int frames;                     // Frames to run ahead (0 = Run() just copies the real display)
+
+    uint64_t Runs() const { return runs; }
+    double LastMicroseconds() const { return lastNanoseconds / 1000.0; }                    // Extra CPU time of the last Run()
+    double MeanMicroseconds() const { return runs ? totalNanoseconds / 1000.0 / runs : 0; } // Average extra CPU time per real frame
+
+private:
+    std::vector<uint8_t> state;     // Real machine while running ahead (allocated once)
+    uint64_t display[32] = {};
+    bool soundOn = false;
+    uint64_t runs = 0;
+    uint64_t lastNanoseconds = 0;
+    uint64_t totalNanoseconds = 0;
+};
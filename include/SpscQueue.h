@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread
+/*
+* A ring of Capacity slots (power of two) with a head index owned by the consumer and a tail index owned by the producer.
+* Each side also keeps a cached copy of the other side's index and only re-reads the shared atomic when the cache says
+* the queue looks full/empty, so in the common case a push or pop touches no cache line the other thread is writing.
+* TryPush fails (returns false) when the queue is full instead of blocking.
+*/
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer thread
+    bool TryPush(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - headCache == Capacity) {
+            headCache = head.load(std::memory_order_acquire);
+            if (t - headCache == Capacity) {
+                return false;
+            }
+        }
+        slots[t & (Capacity - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread
+    bool TryPop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tailCache) {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h == tailCache) {
+                return false;
+            }
+        }
+        value = slots[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head{ 0 };     // Next slot to pop
+    size_t tailCache = 0;                           // Consumer's copy of tail
+    alignas(64) std::atomic<size_t> tail{ 0 };     // Next slot to push
+    size_t headCache = 0;                           // Producer's copy of head
+    alignas(64) T slots[Capacity];
+};
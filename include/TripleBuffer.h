@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer
+/*
+* Three slots: the producer owns one (back), the consumer owns one (front), and the third (middle) holds the newest finished value.
+* Publish() swaps back and middle, Update() swaps front and middle if the middle is newer than what the consumer has.
+* Both are one atomic exchange on a byte that packs the middle slot index and a "fresh" bit, so neither side ever waits for the other:
+* a slow consumer just skips values, a slow producer just means Update() returns false.
+* Each slot sits on its own cache line so the two threads don't fight over lines while writing/reading them.
+*/
+template <typename T>
+class TripleBuffer {
+public:
+    // Producer thread
+    T& Back() { return slots[back].value; }
+    void Publish() {
+        uint8_t old = state.exchange(static_cast<uint8_t>(back | freshBit), std::memory_order_acq_rel);
+        back = old & indexMask;
+    }
+
+    // Consumer thread
+    bool Update() {
+        if (!(state.load(std::memory_order_relaxed) & freshBit)) {
+            return false;
+        }
+        uint8_t old = state.exchange(front, std::memory_order_acq_rel);
+        front = old & indexMask;
+        return true;
+    }
+    const T& Front() const { return slots[front].value; }
+
+private:
+    static constexpr uint8_t indexMask = 0x3;
+    static constexpr uint8_t freshBit = 0x4;
+
+    struct alignas(64) Slot {
+        T value{};
+    };
+    Slot slots[3];
+    alignas(64) std::atomic<uint8_t> state{ 1 };    // Middle slot index | freshBit
+    alignas(64) uint8_t back = 0;                   // Producer only
+    alignas(64) uint8_t front = 2;                  // Consumer only
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// C API of libchip8: the emulator core without SDL, usable from C and anything with a C FFI
+/*
+* Everything goes through an opaque chip8_t handle made by chip8_create(). Nothing here prints or throws, and only chip8_create()
+* and the two ROM loads allocate (running out of memory is a failed load); failures are reported by return values.
+* The functions map one to one onto Chip8 (see Chip8.h): stepping/running, the keypad, the display, the CPU registers and save states.
+* The shared library only exports these functions (C++ users link the static library and use Chip8 directly).
+* New functions may be added, existing ones keep their signature; chip8_api_version() goes up when something is added.
+*/
+
+#if defined(_WIN32) && defined(CHIP8_SHARED)
+#ifdef CHIP8_BUILDING
+#define CHIP8_API __declspec(dllexport)
+#else
+#define CHIP8_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__)
+#define CHIP8_API __attribute__((visibility("default")))
+#else
+#define CHIP8_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHIP8_API_VERSION 3
+
+typedef struct chip8_t chip8_t;
+
+// Snapshot of the CPU state (copied out, changing it doesn't change the machine)
+typedef struct chip8_cpu_state {
+    uint8_t v[16];                  // V0-VF
+    uint16_t index;                 // I
+    uint16_t pc;
+    uint16_t stack[16];
+    uint8_t sp;
+    uint8_t delay_timer;
+    uint8_t sound_timer;
+    uint8_t waiting_for_key;        // FX0A is blocking
+    uint16_t opcode;                // Last executed opcode
+    uint64_t frame_count;           // 60Hz timer ticks so far
+    uint64_t unknown_opcodes;       // Invalid opcodes executed so far
+} chip8_cpu_state;
+
+CHIP8_API int chip8_api_version(void);
+
+CHIP8_API chip8_t* chip8_create(unsigned seed);     // Fixed RNG seed (same ROM + input = same run), NULL if out of memory
+CHIP8_API void chip8_destroy(chip8_t* chip);
+
+CHIP8_API int chip8_load_rom(chip8_t* chip, const uint8_t* data, size_t size);   // Copies the ROM to 0x200, 0 if it doesn't fit
+CHIP8_API int chip8_load_rom_file(chip8_t* chip, const char* path);               // Maps the file read-only and copies it to 0x200 (version 2)
+CHIP8_API const char* chip8_load_error(const chip8_t* chip);                     // Why the last load failed, NULL after a successful one
+CHIP8_API void chip8_reset(chip8_t* chip, unsigned seed);                         // Back to right after the last load, cheap enough to call per episode (version 3)
+
+CHIP8_API void chip8_set_instructions_per_frame(chip8_t* chip, int instructions); // Default 11
+CHIP8_API void chip8_step(chip8_t* chip);                        // One instruction, timers untouched (Chip8::Cycle)
+CHIP8_API int chip8_run_cycles(chip8_t* chip, int cycles);       // Chip8::RunCycles, returns instructions executed
+CHIP8_API int chip8_run_frame(chip8_t* chip);                    // Runs until the next 60Hz timer tick, returns instructions executed
+CHIP8_API void chip8_tick_timers(chip8_t* chip);
+
+CHIP8_API void chip8_set_key(chip8_t* chip, int key, int pressed);  // key 0-F
+CHIP8_API void chip8_set_keys(chip8_t* chip, uint16_t pressed);     // Whole keypad, bit n = key n
+
+CHIP8_API const uint64_t* chip8_display(const chip8_t* chip);    // 32 rows, bit 63 = x 0 (valid until chip8_destroy)
+CHIP8_API void chip8_render_rgba(const chip8_t* chip, uint32_t* pixels);   // 64*32 pixels, 0xFFFFFFFF on / 0 off
+CHIP8_API uint64_t chip8_display_hash(const chip8_t* chip);
+CHIP8_API int chip8_draw_flag(chip8_t* chip);                    // Returns and clears drawFlag
+CHIP8_API int chip8_sound_on(const chip8_t* chip);
+
+CHIP8_API void chip8_get_cpu_state(const chip8_t* chip, chip8_cpu_state* state);
+CHIP8_API const uint8_t* chip8_memory(const chip8_t* chip);      // 4096 bytes, read only
+
+CHIP8_API size_t chip8_snapshot_size(void);                                       // Bytes chip8_save_state writes
+CHIP8_API size_t chip8_save_state(const chip8_t* chip, uint8_t* buffer, size_t size); // Returns bytes written, 0 if buffer is too small
+CHIP8_API int chip8_load_state(chip8_t* chip, const uint8_t* data, size_t size);  // 0 if it's from another version/RNG policy (machine untouched)
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,10 @@
 #include "../include/Chip8.h"
-#include <iostream>
+#include "../include/DisplayExpand.h"
+#include "../include/Profiler.h"
+#include "../include/RomCache.h"
 #include <algorithm>
+#include <bit>
+#include <cstring>
 
 /*
 Each font sprite is 4 pixels wide and 5 pixels tall.
@@ -32,7 +36,12 @@ const uint8_t fontSet[80] = {
     0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 };
 
-Chip8::Chip8() {
+// Seed RNG with current time
+// Queries the steady clock for the current time, computes the duration since its epoch, and extracts the tick count as an integer.
+Chip8::Chip8() : Chip8(static_cast<unsigned>(std::chrono::steady_clock::now().time_since_epoch().count())) {
+}
+
+Chip8::Chip8(unsigned seed) {
     // Load fonts into memory starting at 0x050
     // The first 0x000-0x04F (0-79) were often reserved for other system use (like variables or the interpreter itself in original implementations)
     // So fonts go from 0x050 to 0x09F (80-159, exactly 80 bytes)
@@ -40,117 +49,706 @@ Chip8::Chip8() {
         memory[0x050 + i] = fontSet[i];
     }
 
-    // Seed RNG with current time
-    rngSeed = std::chrono::steady_clock::now().time_since_epoch().count(); // Queries the steady clock for the current time, computes the duration since its epoch, and extracts the tick count as an integer.
-    randGen.seed(rngSeed);
-    randByte = std::uniform_int_distribution<unsigned short>(0, 255);
+    rngSeed = seed;
+    randGen.Seed(rngSeed);
+}
+
+// Bit n set for every 64-byte page of memory[address..address+length) (the range can wrap past 0xFFF)
+static uint64_t PagesOf(uint16_t address, uint16_t length) {
+    if (length >= 4096) {
+        return ~0ull;
+    }
+    if (length == 0) {
+        return 0;
+    }
+    unsigned first = (address & 0x0FFF) / 64;
+    unsigned last = ((address + length - 1) & 0x0FFF) / 64;
+    uint64_t fromFirst = ~0ull << first;
+    uint64_t toLast = ~0ull >> (63 - last);
+    return first <= last ? (fromFirst & toLast) : (fromFirst | toLast);
+}
+
+bool Chip8::LoadROM(const std::string& filename) {
+    // Read the file into an image (size-checked first, mapped and copied, no stream) and load that, the image is what Reset() restores from.
+    // Callers loading the same ROM many times should keep a RomImage from RomCache and use the image overload instead.
+    RomImage image = RomFile::Open(filename, &loadError);
+    if (!image) {
+        return false;
+    }
+    return LoadROM(std::move(image));
 }
 
-bool Chip8::LoadROM(const std::string filename) {
-    // Open the ROM file in binary mode and instantly seek to the end
-    std::ifstream file(filename, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open ROM: " << filename << std::endl;
+bool Chip8::LoadROM(std::span<const uint8_t> rom) {
+    if (rom.size() > sizeof(memory) - 0x200) {
+        loadError = "ROM too large";
         return false;
     }
-    // Get the file size (current position due to std::ios::ate)
-    std::streamsize size = file.tellg();
-    // Reset the file pointer to the beginning for reading
-    file.seekg(0, std::ios::beg);
-    // The CHIP-8 memory starts loading ROMs at 0x200 (512 bytes). And its available memory max ~3583 bytes (from 0x200 to 0xFFF.
-    // The total available space is memory size minus this starting offset.
-    if (size > sizeof(memory) - 0x200) {
-        std::cerr << "ROM too large: " << size << " bytes" << std::endl;
+    // The caller's buffer may not outlive this call, Reset() needs the bytes later: keep a copy (3.5KB at most).
+    // Loops that load one buffer after another (the fuzz harness, once per input) refill the same image instead of
+    // allocating a new one each time, as long as nothing else holds it (only this member and romImage may)
+    long holders = romImage == bufferImage ? 2 : 1;
+    if (bufferImage && bufferImage.use_count() == holders) {
+        if (romImage == bufferImage) {
+            dirtyPages |= PagesOf(0x200, static_cast<uint16_t>(romImage->Bytes().size()));  // The bytes change under romImage: LoadROM(image) below only sees the new size
+        }
+        bufferImage->Assign(rom);
+    }
+    else {
+        bufferImage = RomFile::FromBytes(std::vector<uint8_t>(rom.begin(), rom.end()));
+    }
+    return LoadROM(RomImage(bufferImage));
+}
+
+bool Chip8::LoadROM(RomImage image) {
+    if (!image) {
+        loadError = "No ROM image";
         return false;
     }
-    // Read the ROM content directly into the CHIP-8 memory buffer,
-    // starting at the required program load address (0x200).
-    file.read((char*)(memory + 0x200), size);
-    if (!file) {
-        // This check handles potential read errors (e.g., partial read)
-        std::cerr << "Failed to read ROM" << std::endl;
+    if (image->Bytes().size() > sizeof(memory) - 0x200) {
+        loadError = "ROM too large";
         return false;
     }
+    // Memory becomes font + this ROM + zeros: rebuild the pages the last run wrote, the ones the last ROM covered and the ones this one covers.
+    // Pages nobody touched are already zeros or font, and JIT/AOT code compiled from them stays valid.
+    uint16_t oldSize = romImage ? static_cast<uint16_t>(romImage->Bytes().size()) : 0;
+    dirtyPages |= PagesOf(0x200, oldSize) | PagesOf(0x200, static_cast<uint16_t>(image->Bytes().size()));
+    romImage = std::move(image);
+    RestorePages();
+    loadError = nullptr;
     return true;
 }
 
+void Chip8::RestorePages() {
+    std::span<const uint8_t> rom = romImage ? romImage->Bytes() : std::span<const uint8_t>();
+    // Copies the part of source (placed at memory[start]) that falls inside the page
+    auto copyOverlap = [this](uint16_t page, const uint8_t* source, size_t start, size_t length) {
+        size_t begin = std::max<size_t>(page, start);
+        size_t end = std::min<size_t>(page + 64, start + length);
+        if (begin < end) {
+            std::memcpy(memory + begin, source + (begin - start), end - begin);
+        }
+    };
+    uint64_t pages = dirtyPages;
+    while (pages != 0) {
+        uint16_t page = static_cast<uint16_t>(std::countr_zero(pages) * 64);
+        pages &= pages - 1;
+        std::memset(memory + page, 0, 64);
+        copyOverlap(page, fontSet, 0x050, sizeof(fontSet));
+        copyOverlap(page, rom.data(), 0x200, rom.size());
+        CallCodeWriteHooks(page, 64);
+    }
+    dirtyPages = 0;
+}
+
+/* Reset explanation:
+* Same result as constructing a new Chip8(seed) and calling LoadROM again, for a fraction of the cost:
+* - memory: only the 64-byte pages in dirtyPages are rebuilt (zeros, then the font and the ROM image where they overlap the page)
+*   and compiled JIT/AOT code on them dropped, the rest of memory isn't touched
+* - registers, stack, keypad, display: a handful of memsets (16-256 bytes each, the compiler turns them into vector stores)
+* - RNG: re-seeded with the seed, no clock read
+* Settings (instructionsPerFrame, skipIdleLoops, hooks, profiler) are kept.
+*/
+void Chip8::Reset() {
+    RestorePages();
+
+    std::memset(registers, 0, sizeof(registers));
+    std::memset(stack, 0, sizeof(stack));
+    std::memset(keypad, 0, sizeof(keypad));
+    std::memset(display, 0, sizeof(display));
+    std::memset(dirtyRows, 0, sizeof(dirtyRows));
+    index = 0;
+    pc = 0x200;
+    sp = 0;
+    delayTimer = 0;
+    soundTimer = 0;
+    drawFlag = false;
+    frameCycles = 0;
+    frameCount = 0;
+    waitingForKey = false;
+    keypadReads = 0;
+    unknownOpcodes = 0;
+    lastUnknownOpcode = 0;
+    skippedInstructions = 0;
+    idle = false;
+    opcode = 0;
+    randGen.Seed(rngSeed);
+}
+
+void Chip8::Reset(unsigned seed) {
+    rngSeed = seed;
+    Reset();
+}
+
+void Chip8::NotifyMemoryWrite(uint16_t address, uint16_t length) {
+    // Remember which 64-byte pages were written for Reset()
+    dirtyPages |= PagesOf(address, length);
+    CallCodeWriteHooks(address, length);
+}
+
+bool Chip8::AddCodeWriteHook(CodeWriteHook hook, void* context) {
+    if (codeWriteHookCount == maxCodeWriteHooks) {
+        return false;
+    }
+    codeWriteHooks[codeWriteHookCount++] = { hook, context };
+    return true;
+}
+
+void Chip8::RemoveCodeWriteHook(CodeWriteHook hook, void* context) {
+    for (int i = 0; i < codeWriteHookCount; ++i) {
+        if (codeWriteHooks[i].hook == hook && codeWriteHooks[i].context == context) {
+            // Keep the others in order, they're called in the order they were added
+            std::copy(codeWriteHooks + i + 1, codeWriteHooks + codeWriteHookCount, codeWriteHooks + i);
+            --codeWriteHookCount;
+            return;
+        }
+    }
+}
+
 /* Cycle explanation:
 * Fetch: Read 2 bytes from memory[pc] and memory[pc+1] into opcode.
 * Increment PC by 2 (now points to next potential opcode).
-* Decode: Use switch statements on parts of opcode (example, first nibble) to call the right handler (like OP_0nnn() for 0x0***).
-* Execute: Run the handlers logic (example, for 00E0, clear gfx[]).
+* Decode: Look the opcode up in dispatchTable to find the right handler (like OP_0nnn() for 0x0***).
+* Execute: Run the handlers logic (example, for 00E0, clear display[]).
+*
+* Decoding is one load from the 64K dispatchTable; the handlers pull x/y/n/nn/nnn out of opcode themselves.
+* (A per-address cache of decoded instructions was tried: the entries were bigger than the work they saved,
+* so it was slower than decoding every time and cost 36KB per instance.)
 */
 void Chip8::Cycle() {
-    // Combine two bytes into opcode
-    opcode = (memory[pc] << 8) | memory[pc + 1];
+    Step();
+}
+
+// Fetches and runs the instruction at `at`, returns the address of the next one.
+// pc is only stored for the opcodes that read or change it (jumps, calls, returns, skips, FX0A); the others never look at it,
+// so the batch loops keep pc (and the fetched opcode) in registers and write pc back once at the end.
+inline uint16_t Chip8::Execute(uint16_t at) {
+    // Combine two bytes into opcode (wrap at the end of memory)
+    uint16_t addr = at & 0x0FFF;
+    uint16_t op = static_cast<uint16_t>((memory[addr] << 8) | memory[(addr + 1) & 0x0FFF]);
+    uint8_t handler = dispatchTable[op];
+    opcode = op;  // The handlers take their operands from it
+
+#ifdef CHIP8_PROFILE
+    if (profiler) {
+        profiler->Count(at, handler);
+    }
+#endif
 
     // Increment PC early (some opcodes may change it)
+    uint16_t next = static_cast<uint16_t>(at + 2);
+
+    // A switch on the handler id rather than a call through handlerTable: every case is a direct call the compiler can inline,
+    // so an instruction costs one indirect jump instead of an indirect call plus the handler's prologue/epilogue
+    switch (handler) {
+    case H_0nnn: pc = next; OP_0nnn(); return pc;
+    case H_1nnn: pc = next; OP_1nnn(); return pc;
+    case H_2nnn: pc = next; OP_2nnn(); return pc;
+    case H_3xnn: pc = next; OP_3xnn(); return pc;
+    case H_4xnn: pc = next; OP_4xnn(); return pc;
+    case H_5xy0: pc = next; OP_5xy0(); return pc;
+    case H_6xnn: OP_6xnn(); return next;
+    case H_7xnn: OP_7xnn(); return next;
+    case H_8xy0: OP_8xy0(); return next;
+    case H_8xy1: OP_8xy1(); return next;
+    case H_8xy2: OP_8xy2(); return next;
+    case H_8xy3: OP_8xy3(); return next;
+    case H_8xy4: OP_8xy4(); return next;
+    case H_8xy5: OP_8xy5(); return next;
+    case H_8xy6: OP_8xy6(); return next;
+    case H_8xy7: OP_8xy7(); return next;
+    case H_8xyE: OP_8xyE(); return next;
+    case H_9xy0: pc = next; OP_9xy0(); return pc;
+    case H_Annn: OP_Annn(); return next;
+    case H_Bnnn: pc = next; OP_Bnnn(); return pc;
+    case H_Cxnn: OP_Cxnn(); return next;
+    case H_Dxyn: OP_Dxyn(); return next;
+    case H_Ex9E: pc = next; OP_Ex9E(); return pc;
+    case H_ExA1: pc = next; OP_ExA1(); return pc;
+    case H_Fx07: OP_Fx07(); return next;
+    case H_Fx0A: pc = next; OP_Fx0A(); return pc;
+    case H_Fx15: OP_Fx15(); return next;
+    case H_Fx18: OP_Fx18(); return next;
+    case H_Fx1E: OP_Fx1E(); return next;
+    case H_Fx29: OP_Fx29(); return next;
+    case H_Fx33: OP_Fx33(); return next;
+    case H_Fx55: OP_Fx55(); return next;
+    case H_Fx65: OP_Fx65(); return next;
+    default: OP_NULL(); return next;
+    }
+}
+
+inline void Chip8::Step() {
+    pc = Execute(pc);
+}
+
+/*
+* Batched execution. pc and the loop counters stay in locals for the whole batch and are only written back on exit
+* (see Execute: only the branching handlers see pc), so callers pay one call per batch instead of one per instruction.
+* opcode is fetched into a register and stored once for the handlers; the registers stay in the V0-VF array, the handlers
+* index them with X()/Y() so a local copy would have to be written back after every instruction.
+* Timers tick every instructionsPerFrame instructions, the same as a frontend running that many Cycle() calls per 60Hz frame.
+*/
+int Chip8::RunCycles(int cycles) {
+    const int perFrame = instructionsPerFrame;
+    int frameCycle = frameCycles;
+    int executed = 0;
+    uint16_t address = pc;
+    while (executed < cycles) {
+        address = Execute(address);
+        ++executed;
+        if (++frameCycle >= perFrame) {
+            frameCycle = 0;
+            TickTimers();
+        }
+        if (drawFlag || waitingForKey) {
+            break;
+        }
+    }
+    pc = address;
+    frameCycles = frameCycle;
+    return executed;
+}
+
+int Chip8::RunUntilFrame(int perFrame) {
+    int frameCycle = frameCycles;
+    int executed = 0;
+    uint16_t address = pc;
+    idle = false;
+    while (frameCycle < perFrame) {
+        uint16_t jumpAddress = address;
+        address = Execute(address);
+        ++executed;
+        ++frameCycle;
+        if (waitingForKey) {
+            // The rest of the frame would only re-run FX0A (nothing changes until a key is pressed), skip it.
+            // Each of those runs would have read the keypad, so they're counted as reads like running them would
+            keypadReads += perFrame - frameCycle;
+            skippedInstructions += perFrame - frameCycle;
+            frameCycle = perFrame;
+            idle = true;
+            break;
+        }
+        // 1NNN stored pc on its way out of Execute, so SkipIdleLoop can read the loop from there
+        if ((opcode & 0xF000) == 0x1000 && skipIdleLoops && frameCycle < perFrame) {
+            int skipped = SkipIdleLoop(jumpAddress, perFrame - frameCycle);
+            skippedInstructions += skipped;
+            frameCycle += skipped;
+        }
+        if (drawFlag) {
+            break;
+        }
+    }
+    pc = address;
+    if (frameCycle >= perFrame) {
+        frameCycle = 0;
+        TickTimers();
+    }
+    frameCycles = frameCycle;
+    return executed;
+}
+
+/*
+* Only called right after a 1NNN, so the check costs nothing on other instructions. Two loops are recognised:
+* - "1NNN" jumping to itself: every remaining instruction of the frame is that same jump.
+* - "FX07 / 3XNN or 4XNN / 1NNN back to the FX07": the delay timer only changes on the 60Hz tick, so while the skip keeps
+*   the loop going every iteration does exactly the same thing (VX = delay timer, back to FX07). Whole iterations are skipped
+*   and the caller runs the last partial one normally, so PC/opcode/VX end up exactly where running it all would leave them.
+*/
+int Chip8::SkipIdleLoop(uint16_t jumpAddress, int remaining) {
+    if (pc == jumpAddress) {
+        idle = true;
+        return remaining;
+    }
+    if (static_cast<uint16_t>(pc + 4) != jumpAddress) {
+        return 0;
+    }
+    Instruction read = Decode((memory[pc & 0x0FFF] << 8) | memory[(pc + 1) & 0x0FFF]);
+    Instruction test = Decode((memory[(pc + 2) & 0x0FFF] << 8) | memory[(pc + 3) & 0x0FFF]);
+    if (read.handler != H_Fx07 || (test.handler != H_3xnn && test.handler != H_4xnn) || test.x != read.x) {
+        return 0;
+    }
+    bool loops = test.handler == H_3xnn ? delayTimer != test.nn : delayTimer == test.nn;
+    int iterations = remaining / 3;
+    if (!loops || iterations == 0) {
+        return 0;
+    }
+    registers[read.x] = delayTimer;  // What the skipped FX07s would have left there (opcode is still the 1NNN, same as after each iteration)
+    idle = true;
+    return iterations * 3;
+}
+
+void Chip8::RenderRGBA(uint32_t* pixels) const {
+    ExpandDisplay(display, pixels, 64, 0xFFFFFFFF, 0x00000000, 1);
+}
+
+/*
+* Consecutive dirty rows are merged into one band, and each band becomes one rectangle spanning the leftmost to rightmost changed column.
+* When there are more bands than maxRects, the extra ones are folded into the last rectangle.
+*/
+int Chip8::GetDirtyRegions(DirtyRect* rects, int maxRects) const {
+    int count = 0;
+    int row = 0;
+    while (row < 32 && maxRects > 0) {
+        if (!dirtyRows[row]) {
+            ++row;
+            continue;
+        }
+        int top = row;
+        uint64_t columns = 0;
+        while (row < 32 && dirtyRows[row]) {
+            columns |= dirtyRows[row];
+            ++row;
+        }
+        int left = std::countl_zero(columns);
+        int right = 63 - std::countr_zero(columns);
+        if (count < maxRects) {
+            rects[count++] = { static_cast<uint8_t>(left), static_cast<uint8_t>(top), static_cast<uint8_t>(right - left + 1), static_cast<uint8_t>(row - top) };
+        }
+        else {
+            // Out of rectangles: grow the last one to cover this band too
+            DirtyRect& last = rects[count - 1];
+            int x0 = std::min<int>(last.x, left);
+            int x1 = std::max<int>(last.x + last.w, right + 1);
+            last.x = static_cast<uint8_t>(x0);
+            last.w = static_cast<uint8_t>(x1 - x0);
+            last.h = static_cast<uint8_t>(row - last.y);
+        }
+    }
+    return count;
+}
+
+void Chip8::ClearDirty() {
+    std::fill(std::begin(dirtyRows), std::end(dirtyRows), 0);
+}
+
+uint64_t Chip8::DisplayHash() const {
+    uint64_t hash = 0xCBF29CE484222325ull;  // FNV-1a 64-bit offset basis
+    for (uint64_t row : display) {
+        for (int byte = 7; byte >= 0; --byte) {
+            hash ^= (row >> (byte * 8)) & 0xFF;
+            hash *= 0x100000001B3ull;       // FNV prime
+        }
+    }
+    return hash;
+}
+
+void Chip8::TickTimers() {
+    if (delayTimer > 0) {
+        --delayTimer;
+    }
+    if (soundTimer > 0) {
+        --soundTimer;
+    }
+    ++frameCount;
+}
+
+/*
+* Save states. Every field is written little-endian one after the other (no padding, no pointers), so a blob is a fixed
+* saveStateSize bytes and can be diffed/XORed byte by byte (rewind) or copied around as-is (run-ahead, checkpoints).
+* The keypad is packed into 16 bits and the display is stored as its 32 bit-packed rows (256 bytes).
+* The RNG writes its own state (Rng.h); the header records which RNG policy made the blob, since the states aren't interchangeable.
+*/
+namespace {
+    constexpr uint8_t saveStateMagic[4] = { 'C', '8', 'S', 'S' };
+
+    struct StateWriter {
+        uint8_t* out;
+        void Bytes(const void* data, size_t size) {
+            std::memcpy(out, data, size);
+            out += size;
+        }
+        template <typename T>
+        void Value(T value) {
+            for (size_t i = 0; i < sizeof(T); ++i) {
+                *out++ = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (i * 8));
+            }
+        }
+    };
+
+    struct StateReader {
+        const uint8_t* in;
+        void Bytes(void* data, size_t size) {
+            std::memcpy(data, in, size);
+            in += size;
+        }
+        template <typename T>
+        T Value() {
+            uint64_t value = 0;
+            for (size_t i = 0; i < sizeof(T); ++i) {
+                value |= static_cast<uint64_t>(*in++) << (i * 8);
+            }
+            return static_cast<T>(value);
+        }
+    };
+}
+
+size_t Chip8::SaveState(std::span<uint8_t> buffer) const {
+    if (buffer.size() < saveStateSize) {
+        return 0;
+    }
+    StateWriter writer{ buffer.data() };
+    writer.Bytes(saveStateMagic, sizeof(saveStateMagic));
+    writer.Value<uint16_t>(saveStateVersion);
+    writer.Value<uint16_t>(Chip8Rng::id << 8 | Chip8Rng::stateBytes);
+    writer.Bytes(memory, sizeof(memory));
+    writer.Bytes(registers, sizeof(registers));
+    writer.Value(index);
+    writer.Value(pc);
+    for (uint16_t entry : stack) {
+        writer.Value(entry);
+    }
+    writer.Value(sp);
+    writer.Value(delayTimer);
+    writer.Value(soundTimer);
+    uint16_t keys = 0;
+    for (int key = 0; key < 16; ++key) {
+        keys |= (keypad[key] ? 1 : 0) << key;
+    }
+    writer.Value(keys);
+    for (uint64_t row : display) {
+        writer.Value(row);
+    }
+    writer.Value(opcode);
+    writer.Value<int32_t>(frameCycles);
+    writer.Value(frameCount);
+    writer.Value<uint8_t>(waitingForKey ? 1 : 0);
+    writer.Value<uint32_t>(rngSeed);
+    randGen.Save(writer.out);
+    writer.out += Chip8Rng::stateBytes;
+    return writer.out - buffer.data();
+}
+
+bool Chip8::LoadState(std::span<const uint8_t> state) {
+    if (state.size() < saveStateSize || !std::equal(std::begin(saveStateMagic), std::end(saveStateMagic), state.begin())) {
+        return false;
+    }
+    StateReader reader{ state.data() + sizeof(saveStateMagic) };
+    if (reader.Value<uint16_t>() != saveStateVersion || reader.Value<uint16_t>() != (Chip8Rng::id << 8 | Chip8Rng::stateBytes)) {
+        return false;
+    }
+    // SP is the one field that indexes an array without a mask (00EE reads stack[sp - 1]), refuse a state that would put it past the stack
+    constexpr size_t spOffset = 8 + 4096 + 16 + 2 + 2 + 32;  // Header, memory, V0-VF, I, PC, stack
+    if (state[spOffset] > 16) {
+        return false;
+    }
+
+    // Only copy (and drop the JIT blocks of) the 64-byte chunks that actually differ,
+    // so loading a state taken a few frames ago (rewind, run-ahead) keeps the rest of the compiled code
+    const uint8_t* newMemory = reader.in;
+    for (uint16_t chunk = 0; chunk < sizeof(memory); chunk += 64) {
+        if (std::memcmp(memory + chunk, newMemory + chunk, 64) != 0) {
+            std::memcpy(memory + chunk, newMemory + chunk, 64);
+            NotifyMemoryWrite(chunk, 64);
+        }
+    }
+    reader.in += sizeof(memory);
+
+    reader.Bytes(registers, sizeof(registers));
+    index = reader.Value<uint16_t>();
+    pc = reader.Value<uint16_t>();
+    for (uint16_t& entry : stack) {
+        entry = reader.Value<uint16_t>();
+    }
+    sp = reader.Value<uint8_t>();
+    delayTimer = reader.Value<uint8_t>();
+    soundTimer = reader.Value<uint8_t>();
+    uint16_t keys = reader.Value<uint16_t>();
+    for (int key = 0; key < 16; ++key) {
+        keypad[key] = (keys >> key) & 1;
+    }
+    for (int row = 0; row < 32; ++row) {
+        uint64_t loaded = reader.Value<uint64_t>();
+        dirtyRows[row] |= display[row] ^ loaded;  // The frontend only has to redraw what the state changed
+        display[row] = loaded;
+    }
+    drawFlag = true;
+    opcode = reader.Value<uint16_t>();
+    frameCycles = reader.Value<int32_t>();
+    frameCount = reader.Value<uint64_t>();
+    waitingForKey = reader.Value<uint8_t>() != 0;
+    rngSeed = reader.Value<uint32_t>();
+    randGen.Load(reader.in);
+    return true;
+}
+
+// Reference cycle: decode with the nested switch on every instruction instead of the table
+void Chip8::CycleSwitch() {
+    uint16_t addr = pc & 0x0FFF;
+    opcode = (memory[addr] << 8) | memory[(addr + 1) & 0x0FFF];
     pc += 2;
+    (this->*handlerTable[HandlerFor(opcode)])();
+}
+
+/*
+* Threaded interpreter: every handler jumps straight to the next handler through a label table (GCC/Clang "labels as values")
+* instead of returning to one shared dispatch point, so each opcode gets its own indirect branch for the predictor.
+* Enabled with CHIP8_THREADED_DISPATCH, other builds just loop over Cycle().
+*/
+int Chip8::RunThreaded(int cycles) {
+#if defined(CHIP8_THREADED_DISPATCH) && (defined(__GNUC__) || defined(__clang__))
+    // Same order as the Handler enum in Chip8.h
+    static void* const labels[H_COUNT] = {
+        &&op_0nnn, &&op_1nnn, &&op_2nnn, &&op_3xnn, &&op_4xnn, &&op_5xy0, &&op_6xnn, &&op_7xnn,
+        &&op_8xy0, &&op_8xy1, &&op_8xy2, &&op_8xy3, &&op_8xy4, &&op_8xy5, &&op_8xy6, &&op_8xy7, &&op_8xyE,
+        &&op_9xy0, &&op_Annn, &&op_Bnnn, &&op_Cxnn, &&op_Dxyn, &&op_Ex9E, &&op_ExA1,
+        &&op_Fx07, &&op_Fx0A, &&op_Fx15, &&op_Fx18, &&op_Fx1E, &&op_Fx29, &&op_Fx33, &&op_Fx55, &&op_Fx65,
+        &&op_NULL
+    };
+    int executed = 0;
+#define CHIP8_DISPATCH()                      \
+    if (executed == cycles) return executed;  \
+    ++executed;                               \
+    opcode = (memory[pc & 0x0FFF] << 8) |     \
+        memory[(pc + 1) & 0x0FFF];            \
+    pc += 2;                                  \
+    goto *labels[dispatchTable[opcode]]
+
+    CHIP8_DISPATCH();
+op_0nnn: OP_0nnn(); CHIP8_DISPATCH();
+op_1nnn: OP_1nnn(); CHIP8_DISPATCH();
+op_2nnn: OP_2nnn(); CHIP8_DISPATCH();
+op_3xnn: OP_3xnn(); CHIP8_DISPATCH();
+op_4xnn: OP_4xnn(); CHIP8_DISPATCH();
+op_5xy0: OP_5xy0(); CHIP8_DISPATCH();
+op_6xnn: OP_6xnn(); CHIP8_DISPATCH();
+op_7xnn: OP_7xnn(); CHIP8_DISPATCH();
+op_8xy0: OP_8xy0(); CHIP8_DISPATCH();
+op_8xy1: OP_8xy1(); CHIP8_DISPATCH();
+op_8xy2: OP_8xy2(); CHIP8_DISPATCH();
+op_8xy3: OP_8xy3(); CHIP8_DISPATCH();
+op_8xy4: OP_8xy4(); CHIP8_DISPATCH();
+op_8xy5: OP_8xy5(); CHIP8_DISPATCH();
+op_8xy6: OP_8xy6(); CHIP8_DISPATCH();
+op_8xy7: OP_8xy7(); CHIP8_DISPATCH();
+op_8xyE: OP_8xyE(); CHIP8_DISPATCH();
+op_9xy0: OP_9xy0(); CHIP8_DISPATCH();
+op_Annn: OP_Annn(); CHIP8_DISPATCH();
+op_Bnnn: OP_Bnnn(); CHIP8_DISPATCH();
+op_Cxnn: OP_Cxnn(); CHIP8_DISPATCH();
+op_Dxyn: OP_Dxyn(); CHIP8_DISPATCH();
+op_Ex9E: OP_Ex9E(); CHIP8_DISPATCH();
+op_ExA1: OP_ExA1(); CHIP8_DISPATCH();
+op_Fx07: OP_Fx07(); CHIP8_DISPATCH();
+op_Fx0A: OP_Fx0A(); CHIP8_DISPATCH();
+op_Fx15: OP_Fx15(); CHIP8_DISPATCH();
+op_Fx18: OP_Fx18(); CHIP8_DISPATCH();
+op_Fx1E: OP_Fx1E(); CHIP8_DISPATCH();
+op_Fx29: OP_Fx29(); CHIP8_DISPATCH();
+op_Fx33: OP_Fx33(); CHIP8_DISPATCH();
+op_Fx55: OP_Fx55(); CHIP8_DISPATCH();
+op_Fx65: OP_Fx65(); CHIP8_DISPATCH();
+op_NULL: OP_NULL(); CHIP8_DISPATCH();
+#undef CHIP8_DISPATCH
+#else
+    for (int i = 0; i < cycles; ++i) {
+        Cycle();
+    }
+    return cycles;
+#endif
+}
+
+// Same order as the Handler enum in Chip8.h
+void (Chip8::* const Chip8::handlerTable[H_COUNT])() = {
+    &Chip8::OP_0nnn, &Chip8::OP_1nnn, &Chip8::OP_2nnn, &Chip8::OP_3xnn, &Chip8::OP_4xnn, &Chip8::OP_5xy0, &Chip8::OP_6xnn, &Chip8::OP_7xnn,
+    &Chip8::OP_8xy0, &Chip8::OP_8xy1, &Chip8::OP_8xy2, &Chip8::OP_8xy3, &Chip8::OP_8xy4, &Chip8::OP_8xy5, &Chip8::OP_8xy6, &Chip8::OP_8xy7, &Chip8::OP_8xyE,
+    &Chip8::OP_9xy0, &Chip8::OP_Annn, &Chip8::OP_Bnnn, &Chip8::OP_Cxnn, &Chip8::OP_Dxyn, &Chip8::OP_Ex9E, &Chip8::OP_ExA1,
+    &Chip8::OP_Fx07, &Chip8::OP_Fx0A, &Chip8::OP_Fx15, &Chip8::OP_Fx18, &Chip8::OP_Fx1E, &Chip8::OP_Fx29, &Chip8::OP_Fx33, &Chip8::OP_Fx55, &Chip8::OP_Fx65,
+    &Chip8::OP_NULL
+};
 
-    // Decode and execute based on first nibble (opcode >> 12)
+// The decode tree: first nibble, then the last nibble (8XYN) or last byte (EXNN, FXNN)
+constexpr uint8_t Chip8::HandlerFor(uint16_t opcode) {
+    // Decode based on first nibble (opcode >> 12)
     switch (opcode >> 12) {
-    case 0x0: OP_0nnn(); break;
-    case 0x1: OP_1nnn(); break;
-    case 0x2: OP_2nnn(); break;
-    case 0x3: OP_3xnn(); break;
-    case 0x4: OP_4xnn(); break;
-    case 0x5: OP_5xy0(); break;
-    case 0x6: OP_6xnn(); break;
-    case 0x7: OP_7xnn(); break;
+    case 0x0: return H_0nnn;
+    case 0x1: return H_1nnn;
+    case 0x2: return H_2nnn;
+    case 0x3: return H_3xnn;
+    case 0x4: return H_4xnn;
+    case 0x5: return H_5xy0;
+    case 0x6: return H_6xnn;
+    case 0x7: return H_7xnn;
     case 0x8: {
         // Sub-switch for last nibble
         switch (opcode & 0x000F) {
-        case 0x0: OP_8xy0(); break;
-        case 0x1: OP_8xy1(); break;
-        case 0x2: OP_8xy2(); break;
-        case 0x3: OP_8xy3(); break;
-        case 0x4: OP_8xy4(); break;
-        case 0x5: OP_8xy5(); break;
-        case 0x6: OP_8xy6(); break;
-        case 0x7: OP_8xy7(); break;
-        case 0xE: OP_8xyE(); break;
-        default: OP_NULL(); break;
+        case 0x0: return H_8xy0;
+        case 0x1: return H_8xy1;
+        case 0x2: return H_8xy2;
+        case 0x3: return H_8xy3;
+        case 0x4: return H_8xy4;
+        case 0x5: return H_8xy5;
+        case 0x6: return H_8xy6;
+        case 0x7: return H_8xy7;
+        case 0xE: return H_8xyE;
+        default: return H_NULL;
         }
-        break;
     }
-    case 0x9: OP_9xy0(); break;
-    case 0xA: OP_Annn(); break;
-    case 0xB: OP_Bnnn(); break;
-    case 0xC: OP_Cxnn(); break;
-    case 0xD: OP_Dxyn(); break;
+    case 0x9: return H_9xy0;
+    case 0xA: return H_Annn;
+    case 0xB: return H_Bnnn;
+    case 0xC: return H_Cxnn;
+    case 0xD: return H_Dxyn;
     case 0xE: {
         switch (opcode & 0x00FF) {
-        case 0x009E: OP_Ex9E(); break;
-        case 0x00A1: OP_ExA1(); break;
-        default: OP_NULL(); break;
+        case 0x009E: return H_Ex9E;
+        case 0x00A1: return H_ExA1;
+        default: return H_NULL;
         }
-        break;
     }
     case 0xF: {
         switch (opcode & 0x00FF) {
-        case 0x0007: OP_Fx07(); break;
-        case 0x000A: OP_Fx0A(); break;
-        case 0x0015: OP_Fx15(); break;
-        case 0x0018: OP_Fx18(); break;
-        case 0x001E: OP_Fx1E(); break;
-        case 0x0029: OP_Fx29(); break;
-        case 0x0033: OP_Fx33(); break;
-        case 0x0055: OP_Fx55(); break;
-        case 0x0065: OP_Fx65(); break;
-        default: OP_NULL(); break;
+        case 0x0007: return H_Fx07;
+        case 0x000A: return H_Fx0A;
+        case 0x0015: return H_Fx15;
+        case 0x0018: return H_Fx18;
+        case 0x001E: return H_Fx1E;
+        case 0x0029: return H_Fx29;
+        case 0x0033: return H_Fx33;
+        case 0x0055: return H_Fx55;
+        case 0x0065: return H_Fx65;
+        default: return H_NULL;
         }
-        break;
     }
-    default: OP_NULL(); break;
+    default: return H_NULL;
+    }
+}
+
+// Every 16-bit opcode -> handler id, built by the compiler from HandlerFor() (64KB, no switch at run time)
+constexpr std::array<uint8_t, 0x10000> Chip8::BuildDispatchTable() {
+    std::array<uint8_t, 0x10000> table = {};
+    for (uint32_t opcode = 0; opcode < 0x10000; ++opcode) {
+        table[opcode] = HandlerFor(static_cast<uint16_t>(opcode));
     }
+    return table;
+}
+
+constinit const std::array<uint8_t, 0x10000> Chip8::dispatchTable = Chip8::BuildDispatchTable();
+
+Chip8::Instruction Chip8::Operands(uint16_t opcode, uint8_t handler) {
+    Instruction decoded;
+    decoded.opcode = opcode;
+    decoded.nnn = opcode & 0x0FFF;
+    decoded.nn = opcode & 0x00FF;
+    decoded.n = opcode & 0x000F;
+    decoded.x = (opcode & 0x0F00) >> 8;
+    decoded.y = (opcode & 0x00F0) >> 4;
+    decoded.handler = handler;
+    return decoded;
+}
+
+Chip8::Instruction Chip8::Decode(uint16_t opcode) {
+    return Operands(opcode, dispatchTable[opcode]);
 }
 
 // https://johnearnest.github.io/Octo/docs/chip8ref.pdf
-// Stub implementations for all opcode handlers
+// Handlers read their operands from opcode (X(), Y(), N(), NN(), NNN())
 void Chip8::OP_0nnn() {
-    switch (opcode & 0x0FFF) {  // Look at last 12 bits
+    switch (NNN()) {  // Look at last 12 bits
     case 0x0E0:  // 00E0: Clear screen
-        std::fill(std::begin(gfx), std::end(gfx), 0);  // Set all pixels to 0 (off)
+        for (int row = 0; row < 32; ++row) {
+            dirtyRows[row] |= display[row];  // Only pixels that were on change
+        }
+        std::fill(std::begin(display), std::end(display), 0);  // Set all pixels to 0 (off), 32 rows of 64 bits
         drawFlag = true;
         break;
     case 0x0EE:  // 00EE: Return from subroutine
@@ -166,46 +764,198 @@ void Chip8::OP_0nnn() {
 }
 // Jump to address nnn (1nnn)
 void Chip8::OP_1nnn() {
-    pc = opcode & 0x0FFF;  // Set PC to nnn (no +2 since we already incremented)
+    pc = NNN();  // Set PC to nnn (no +2 since we already incremented)
+}
+// Call subroutine at nnn (2nnn)
+void Chip8::OP_2nnn() {
+    if (sp < 16) {
+        stack[sp] = pc;  // Push return address (already points past the call)
+        ++sp;
+        pc = NNN();
+    }
+}
+// Skip if VX == nn (3xnn)
+void Chip8::OP_3xnn() {
+    if (registers[X()] == NN()) {
+        pc += 2;
+    }
+}
+// Skip if VX != nn (4xnn)
+void Chip8::OP_4xnn() {
+    if (registers[X()] != NN()) {
+        pc += 2;
+    }
+}
+// Skip if VX == VY (5xy0)
+void Chip8::OP_5xy0() {
+    if (registers[X()] == registers[Y()]) {
+        pc += 2;
+    }
 }
-void Chip8::OP_2nnn() { /* Call subroutine at nnn */ }
-void Chip8::OP_3xnn() { /* Skip if VX == nn */ }
-void Chip8::OP_4xnn() { /* Skip if VX != nn */ }
-void Chip8::OP_5xy0() { /* Skip if VX == VY */ }
 // Set VX = nn (6xnn)
 void Chip8::OP_6xnn() {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    registers[x] = opcode & 0x00FF;
-}
-void Chip8::OP_7xnn() { /* Add nn to VX */ }
-void Chip8::OP_8xy0() { /* Set VX = VY */ }
-void Chip8::OP_8xy1() { /* Set VX = VX | VY */ }
-void Chip8::OP_8xy2() { /* Set VX = VX & VY */ }
-void Chip8::OP_8xy3() { /* Set VX = VX ^ VY */ }
-void Chip8::OP_8xy4() { /* Add VY to VX, VF carry */ }
-void Chip8::OP_8xy5() { /* Subtract VY from VX, VF borrow */ }
-void Chip8::OP_8xy6() { /* Shift VX right, VF LSB */ }
-void Chip8::OP_8xy7() { /* Set VX = VY - VX, VF borrow */ }
-void Chip8::OP_8xyE() { /* Shift VX left, VF MSB */ }
-void Chip8::OP_9xy0() { /* Skip if VX != VY */ }
+    registers[X()] = NN();
+}
+// Add nn to VX, no carry (7xnn)
+void Chip8::OP_7xnn() {
+    registers[X()] += NN();
+}
+// Set VX = VY (8xy0)
+void Chip8::OP_8xy0() {
+    registers[X()] = registers[Y()];
+}
+// Set VX = VX | VY (8xy1)
+void Chip8::OP_8xy1() {
+    registers[X()] |= registers[Y()];
+}
+// Set VX = VX & VY (8xy2)
+void Chip8::OP_8xy2() {
+    registers[X()] &= registers[Y()];
+}
+// Set VX = VX ^ VY (8xy3)
+void Chip8::OP_8xy3() {
+    registers[X()] ^= registers[Y()];
+}
+// Add VY to VX, VF = carry (8xy4)
+// VF is written last so the flag wins when X is F
+void Chip8::OP_8xy4() {
+    uint16_t sum = registers[X()] + registers[Y()];
+    registers[X()] = sum & 0xFF;
+    registers[0xF] = sum > 0xFF ? 1 : 0;
+}
+// Subtract VY from VX, VF = NOT borrow (8xy5)
+void Chip8::OP_8xy5() {
+    uint8_t flag = registers[X()] >= registers[Y()] ? 1 : 0;
+    registers[X()] -= registers[Y()];
+    registers[0xF] = flag;
+}
+// Shift VX right, VF = bit shifted out (8xy6)
+void Chip8::OP_8xy6() {
+    uint8_t flag = registers[X()] & 0x1;
+    registers[X()] >>= 1;
+    registers[0xF] = flag;
+}
+// Set VX = VY - VX, VF = NOT borrow (8xy7)
+void Chip8::OP_8xy7() {
+    uint8_t flag = registers[Y()] >= registers[X()] ? 1 : 0;
+    registers[X()] = registers[Y()] - registers[X()];
+    registers[0xF] = flag;
+}
+// Shift VX left, VF = bit shifted out (8xyE)
+void Chip8::OP_8xyE() {
+    uint8_t flag = (registers[X()] & 0x80) >> 7;
+    registers[X()] <<= 1;
+    registers[0xF] = flag;
+}
+// Skip if VX != VY (9xy0)
+void Chip8::OP_9xy0() {
+    if (registers[X()] != registers[Y()]) {
+        pc += 2;
+    }
+}
 // Set I = nnn (Annn)
 void Chip8::OP_Annn() {
-    index = opcode & 0x0FFF;
-}
-void Chip8::OP_Bnnn() { /* Jump to nnn + V0 */ }
-void Chip8::OP_Cxnn() { /* Set VX to random & nn */ }
-void Chip8::OP_Dxyn() { /* Draw sprite at (VX,VY) height n */ }
-void Chip8::OP_Ex9E() { /* Skip if key VX pressed */ }
-void Chip8::OP_ExA1() { /* Skip if key VX not pressed */ }
-void Chip8::OP_Fx07() { /* Set VX = delay timer */ }
-void Chip8::OP_Fx0A() { /* Wait for key press, store in VX */ }
-void Chip8::OP_Fx15() { /* Set delay timer = VX */ }
-void Chip8::OP_Fx18() { /* Set sound timer = VX */ }
-void Chip8::OP_Fx1E() { /* Add VX to I */ }
-void Chip8::OP_Fx29() { /* Set I to font sprite for VX */ }
-void Chip8::OP_Fx33() { /* Store BCD of VX at I,I+1,I+2 */ }
-void Chip8::OP_Fx55() { /* Store V0-VX at I to I+X */ }
-void Chip8::OP_Fx65() { /* Load V0-VX from I to I+X */ }
+    index = NNN();
+}
+// Jump to nnn + V0 (Bnnn)
+void Chip8::OP_Bnnn() {
+    pc = NNN() + registers[0];
+}
+// Set VX = random byte & nn (Cxnn)
+void Chip8::OP_Cxnn() {
+    registers[X()] = randGen.NextByte() & NN();
+}
+// Draw sprite at (VX, VY) with height n, VF = collision (Dxyn)
+/*
+* Sprite rows are read from memory starting at I, one byte per row (MSB = leftmost pixel).
+* The start position wraps around the screen, but the sprite itself is clipped at the right and bottom edges.
+* Each sprite row is shifted into place in a 64-bit word: bits that would land past x = 63 fall off the end (clipping),
+* the row is XORed in one go and any bit set in both means a pixel was turned off (collision).
+*/
+void Chip8::OP_Dxyn() {
+    uint8_t xPos = registers[X()] % 64;
+    uint8_t yPos = registers[Y()] % 32;
+    uint64_t collision = 0;
+
+    for (int row = 0; row < N() && yPos + row < 32; ++row) {
+        uint64_t spriteRow = (static_cast<uint64_t>(memory[(index + row) & 0x0FFF]) << 56) >> xPos;
+        collision |= display[yPos + row] & spriteRow;
+        display[yPos + row] ^= spriteRow;
+        dirtyRows[yPos + row] |= spriteRow;
+    }
+    registers[0xF] = collision ? 1 : 0;
+    drawFlag = true;
+}
+// Skip if key VX pressed (Ex9E)
+void Chip8::OP_Ex9E() {
+    ++keypadReads;
+    if (keypad[registers[X()] & 0xF]) {
+        pc += 2;
+    }
+}
+// Skip if key VX not pressed (ExA1)
+void Chip8::OP_ExA1() {
+    ++keypadReads;
+    if (!keypad[registers[X()] & 0xF]) {
+        pc += 2;
+    }
+}
+// Set VX = delay timer (Fx07)
+void Chip8::OP_Fx07() {
+    registers[X()] = delayTimer;
+}
+// Wait for key press, store in VX (Fx0A)
+void Chip8::OP_Fx0A() {
+    ++keypadReads;
+    for (uint8_t key = 0; key < 16; ++key) {
+        if (keypad[key]) {
+            registers[X()] = key;
+            waitingForKey = false;
+            return;
+        }
+    }
+    pc -= 2;  // No key yet: run this instruction again next cycle
+    waitingForKey = true;
+}
+// Set delay timer = VX (Fx15)
+void Chip8::OP_Fx15() {
+    delayTimer = registers[X()];
+}
+// Set sound timer = VX (Fx18)
+void Chip8::OP_Fx18() {
+    soundTimer = registers[X()];
+}
+// Add VX to I (Fx1E)
+void Chip8::OP_Fx1E() {
+    index += registers[X()];
+}
+// Set I to font sprite for digit VX (Fx29), fonts start at 0x050 and are 5 bytes each
+void Chip8::OP_Fx29() {
+    index = 0x050 + (registers[X()] & 0xF) * 5;
+}
+// Store BCD of VX at I, I+1, I+2 (Fx33)
+void Chip8::OP_Fx33() {
+    uint8_t value = registers[X()];
+    memory[index & 0x0FFF] = value / 100;
+    memory[(index + 1) & 0x0FFF] = (value / 10) % 10;
+    memory[(index + 2) & 0x0FFF] = value % 10;
+    NotifyMemoryWrite(index, 3);  // The ROM may have just overwritten its own code
+}
+// Store V0-VX at I to I+X (Fx55)
+void Chip8::OP_Fx55() {
+    for (int i = 0; i <= X(); ++i) {
+        memory[(index + i) & 0x0FFF] = registers[i];
+    }
+    NotifyMemoryWrite(index, X() + 1);
+}
+// Load V0-VX from I to I+X (Fx65)
+void Chip8::OP_Fx65() {
+    for (int i = 0; i <= X(); ++i) {
+        registers[i] = memory[(index + i) & 0x0FFF];
+    }
+}
+// Invalid opcode: counted instead of printed, the core doesn't do any I/O while running (frontends/tools report unknownOpcodes)
 void Chip8::OP_NULL() {
-    std::cout << "Unknown opcode: 0x" << std::hex << opcode << std::endl;
+    ++unknownOpcodes;
+    lastUnknownOpcode = opcode;
 }
\ No newline at end of file
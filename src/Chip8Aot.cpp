@@ -0,0 +1,68 @@
+#include "../include/Chip8Aot.h"
+#include <algorithm>
+#include <cstring>
+
+Chip8Aot::Chip8Aot(Chip8& chip, const Chip8AotProgram& program) : chip(chip), program(program) {
+    // Without the hook we'd never hear about writes to the ROM, so if every slot is taken leave all blocks off (Run() = Cycle())
+    if (!chip.AddCodeWriteHook(&Chip8Aot::CodeWriteHook, this)) {
+        return;
+    }
+    for (size_t i = 0; i < program.blockCount; ++i) {
+        const Chip8AotBlock& block = program.blocks[i];
+        compiled[block.address] = &block;
+        maxBlockBytes = std::max(maxBlockBytes, block.bytes);
+    }
+    Invalidate(0x200, 4096 - 0x200);  // Only enable the blocks that match what's loaded right now
+}
+
+Chip8Aot::~Chip8Aot() {
+    chip.RemoveCodeWriteHook(&Chip8Aot::CodeWriteHook, this);
+}
+
+void Chip8Aot::CodeWriteHook(void* context, uint16_t address, uint16_t length) {
+    static_cast<Chip8Aot*>(context)->Invalidate(address, length);
+}
+
+/*
+* Unlike the JIT nothing can be recompiled at run time, so a block isn't dropped on a write: it's switched off while its bytes
+* differ from the ROM and switched back on if they match again (ROMs that patch an instruction and later restore it,
+* LoadROM/LoadState going back to the original program).
+*/
+void Chip8Aot::Invalidate(uint16_t address, uint16_t length) {
+    address &= 0x0FFF;
+    if (address + length > 4096) {
+        Invalidate(0, static_cast<uint16_t>(address + length - 4096));  // FX33/FX55 writes wrap around the end of memory
+    }
+    int first = std::max(address - maxBlockBytes, 0x200);
+    int last = std::min(address + length, 4096);
+    for (int start = first; start < last; ++start) {
+        const Chip8AotBlock* block = compiled[start];
+        if (!block || start + block->bytes <= address) {
+            continue;
+        }
+        bool same = std::memcmp(chip.memory + start, program.rom + (start - 0x200), block->bytes) == 0;
+        blocks[start] = same ? block : nullptr;
+    }
+}
+
+size_t Chip8Aot::ActiveBlocks() const {
+    return std::count_if(std::begin(blocks), std::end(blocks), [](const Chip8AotBlock* block) { return block != nullptr; });
+}
+
+int Chip8Aot::Run(int cycles) {
+    int executed = 0;
+    while (executed < cycles) {
+        const Chip8AotBlock* block = chip.pc < 4096 ? blocks[chip.pc] : nullptr;
+        // Not compiled, changed since, or the block would run past the requested count: interpret one instruction
+        if (!block || executed + block->instructions > cycles) {
+            chip.Cycle();
+            ++executed;
+            continue;
+        }
+        // Copy the count first: FX33/FX55 at the end of the block may switch the block itself off
+        int instructions = block->instructions;
+        block->fn(chip);
+        executed += instructions;
+    }
+    return executed;
+}
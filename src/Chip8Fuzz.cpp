@@ -0,0 +1,56 @@
+#include "../include/Chip8Fuzz.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+Chip8Fuzz::Chip8Fuzz(uint8_t* coverageMap, int cycles, unsigned seed)
+    : chip(std::make_unique<Chip8>(seed)), map(coverageMap), cycles(cycles), seed(seed) {
+    if (!map) {
+        ownMap = std::make_unique<uint8_t[]>(mapSize);
+        map = ownMap.get();
+    }
+    chip->skipIdleLoops = false;  // Cycle() doesn't skip anyway, keep it explicit: every instruction is counted
+}
+
+int Chip8Fuzz::Run(std::span<const uint8_t> input) {
+    Chip8& c = *chip;
+
+    // LoadROM rebuilds the pages the last input wrote or covered, so memory is exactly "font + this input + zeros" no matter what ran before,
+    // then Reset() clears the registers/display (memory is already clean, it has nothing left to copy)
+    size_t romSize = std::min(input.size(), sizeof(c.memory) - 0x200);
+    c.LoadROM(input.first(romSize));
+    c.Reset(seed);
+    c.keypad[0] = 1;
+
+    const int perFrame = c.instructionsPerFrame;
+    int frameCycle = 0;
+    uint32_t previous = 0;
+    for (int i = 0; i < cycles; ++i) {
+        uint16_t address = c.pc & 0x0FFF;
+        c.Cycle();
+        // The handler of the opcode that ran (memory at the address may already be different if it overwrote itself)
+        uint32_t location = ((static_cast<uint32_t>(address) << 6 | Chip8::dispatchTable[c.opcode]) * 0x9E3779B1u) >> 16;
+        ++map[(location ^ previous) & (mapSize - 1)];
+        previous = location >> 1;
+
+        if (++frameCycle == perFrame) {
+            frameCycle = 0;
+            c.TickTimers();
+            std::memset(c.keypad, 0, sizeof(c.keypad));
+            c.keypad[(c.frameCount / 4) & 0xF] = 1;
+        }
+    }
+
+    if (c.sp > 16) {
+        std::abort();  // The stack pointer left the stack: report it as a crash
+    }
+    return cycles;
+}
+
+size_t Chip8Fuzz::EdgesHit() const {
+    return static_cast<size_t>(std::count_if(map, map + mapSize, [](uint8_t count) { return count != 0; }));
+}
+
+void Chip8Fuzz::ClearMap() {
+    std::memset(map, 0, mapSize);
+}
@@ -0,0 +1,343 @@
+#include "../include/Chip8Jit.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CHIP8_JIT_X64 1
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+#ifdef CHIP8_JIT_X64
+/*
+* Tiny x86-64 emitter. Only what the translator needs:
+* rbx holds the Chip8 pointer for the whole block, every CHIP-8 field is addressed as [rbx + disp32],
+* and eax/ecx/edx are scratch registers (reg numbers 0/1/2 in the ModRM byte).
+*/
+struct Emitter {
+    std::vector<uint8_t> bytes;
+
+    void Byte(uint8_t b) { bytes.push_back(b); }
+    void Imm16(uint16_t v) { Byte(v & 0xFF); Byte(v >> 8); }
+    void Imm32(uint32_t v) { for (int i = 0; i < 4; ++i) Byte((v >> (8 * i)) & 0xFF); }
+    void Imm64(uint64_t v) { for (int i = 0; i < 8; ++i) Byte((v >> (8 * i)) & 0xFF); }
+    void Mem(uint8_t reg, int32_t disp) { Byte(0x80 | (reg << 3) | 3); Imm32(disp); }  // mod=10 rm=rbx
+
+    void Load8(uint8_t reg, int32_t disp) { Byte(0x0F); Byte(0xB6); Mem(reg, disp); }              // movzx r32, byte [rbx+disp]
+    void Store8(uint8_t reg, int32_t disp) { Byte(0x88); Mem(reg, disp); }                         // mov byte [rbx+disp], r8
+    void Store8Imm(int32_t disp, uint8_t v) { Byte(0xC6); Mem(0, disp); Byte(v); }                 // mov byte [rbx+disp], imm8
+    void Store16(uint8_t reg, int32_t disp) { Byte(0x66); Byte(0x89); Mem(reg, disp); }            // mov word [rbx+disp], r16
+    void Store16Imm(int32_t disp, uint16_t v) { Byte(0x66); Byte(0xC7); Mem(0, disp); Imm16(v); }  // mov word [rbx+disp], imm16
+    void MovImm(uint8_t reg, uint32_t v) { Byte(0xB8 + reg); Imm32(v); }                           // mov r32, imm32
+    void RegOp(uint8_t op, uint8_t dst, uint8_t src) { Byte(op); Byte(0xC0 | (src << 3) | dst); }  // op r/m32(dst), r32(src)
+};
+
+enum : uint8_t { EAX = 0, ECX = 1, EDX = 2 };
+#endif
+
+// Called from the generated code for every opcode that isn't translated natively
+static void CycleThunk(Chip8* chip) {
+    chip->Cycle();
+}
+
+Chip8Jit::Chip8Jit(Chip8& chip) : chip(chip) {
+#ifdef CHIP8_JIT_X64
+#ifdef _WIN32
+    code = static_cast<uint8_t*>(VirtualAlloc(nullptr, codeSize, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
+#else
+    void* mem = mmap(nullptr, codeSize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    code = mem == MAP_FAILED ? nullptr : static_cast<uint8_t*>(mem);
+#endif
+#endif
+    // Without the hook we'd never hear about writes to compiled code, so if every slot is taken stay unavailable (Run() = Cycle())
+    if (code && !chip.AddCodeWriteHook(&Chip8Jit::CodeWriteHook, this)) {
+        FreeCode();
+    }
+}
+
+Chip8Jit::~Chip8Jit() {
+    chip.RemoveCodeWriteHook(&Chip8Jit::CodeWriteHook, this);
+    FreeCode();
+}
+
+void Chip8Jit::FreeCode() {
+#ifdef CHIP8_JIT_X64
+    if (code) {
+#ifdef _WIN32
+        VirtualFree(code, 0, MEM_RELEASE);
+#else
+        munmap(code, codeSize);
+#endif
+    }
+#endif
+    code = nullptr;
+}
+
+void Chip8Jit::CodeWriteHook(void* context, uint16_t address, uint16_t length) {
+    static_cast<Chip8Jit*>(context)->Invalidate(address, length);
+}
+
+void Chip8Jit::Invalidate(uint16_t address, uint16_t length) {
+    // Writes land on memory[address & 0xFFF], and FX33/FX55 with I near (or past) the end of memory wrap around to 0
+    address &= 0x0FFF;
+    length = std::min<uint16_t>(length, 4096);
+    if (address + length > 4096) {
+        Invalidate(0, static_cast<uint16_t>(address + length - 4096));
+    }
+    // A block starting up to maxBlockInstructions*2 bytes before the write can still reach into it
+    int first = address - maxBlockInstructions * 2;
+    for (int start = first < 0 ? 0 : first; start < address + length && start < 4096; ++start) {
+        if (blocks[start].fn && start + blocks[start].bytes > address) {
+            blocks[start] = Block{};
+        }
+    }
+}
+
+void Chip8Jit::Flush() {
+    std::fill(std::begin(blocks), std::end(blocks), Block{});
+    codeUsed = 0;
+}
+
+int Chip8Jit::Run(int cycles) {
+    int executed = 0;
+    while (executed < cycles) {
+        uint16_t addr = chip.pc;
+        const Block* block = addr < 4096 ? &blocks[addr] : nullptr;
+        if (block && !block->fn) {
+            block = Compile(addr);
+        }
+        // Not compilable, or the block would run past the requested count: interpret one instruction
+        if (!block || !block->fn || executed + block->instructions > cycles) {
+            chip.Cycle();
+            ++executed;
+            continue;
+        }
+        // Copy the count first: FX33/FX55 inside the block may invalidate the block itself
+        int instructions = block->instructions;
+        block->fn(&chip);
+        executed += instructions;
+    }
+    return executed;
+}
+
+const Chip8Jit::Block* Chip8Jit::Compile(uint16_t address) {
+#ifdef CHIP8_JIT_X64
+    if (!code || address < 0x200) {
+        return nullptr;
+    }
+
+    // Field offsets inside this Chip8 object, used as [rbx + disp32]
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&chip);
+    const int32_t regs = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(chip.registers) - base);
+    const int32_t vf = regs + 0xF;
+    const int32_t indexOff = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&chip.index) - base);
+    const int32_t pcOff = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&chip.pc) - base);
+    const int32_t opcodeOff = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&chip.opcode) - base);
+    const int32_t delayOff = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&chip.delayTimer) - base);
+    const int32_t soundOff = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&chip.soundTimer) - base);
+
+    Emitter e;
+    // Prologue: keep the Chip8 pointer in rbx and leave 32 bytes of shadow space (Win64) with the stack 16-byte aligned for calls
+    e.Byte(0x53);                                   // push rbx
+#ifdef _WIN32
+    e.Byte(0x48); e.Byte(0x89); e.Byte(0xCB);       // mov rbx, rcx
+#else
+    e.Byte(0x48); e.Byte(0x89); e.Byte(0xFB);       // mov rbx, rdi
+#endif
+    e.Byte(0x48); e.Byte(0x83); e.Byte(0xEC); e.Byte(0x20);  // sub rsp, 32
+
+    auto callCycle = [&](uint16_t pc) {
+        e.Store16Imm(pcOff, pc);                    // Cycle() fetches from pc
+#ifdef _WIN32
+        e.Byte(0x48); e.Byte(0x89); e.Byte(0xD9);   // mov rcx, rbx
+#else
+        e.Byte(0x48); e.Byte(0x89); e.Byte(0xDF);   // mov rdi, rbx
+#endif
+        e.Byte(0x48); e.Byte(0xB8); e.Imm64(reinterpret_cast<uint64_t>(&CycleThunk));  // mov rax, imm64
+        e.Byte(0xFF); e.Byte(0xD0);                 // call rax
+    };
+    // pc = condition ? skip : next. Flags must already be set by a cmp
+    auto skipIf = [&](uint8_t cmovcc, uint16_t next) {
+        e.MovImm(ECX, next);
+        e.MovImm(EDX, next + 2);
+        e.Byte(0x0F); e.Byte(cmovcc); e.Byte(0xCA);  // cmovcc ecx, edx
+        e.Store16(ECX, pcOff);
+    };
+
+    uint16_t pc = address;
+    int count = 0;
+    bool ended = false;          // Last instruction already set pc
+    bool lastWasCycle = false;   // Last instruction went through Cycle() (which stores opcode itself)
+    uint16_t lastOpcode = 0;
+    while (!ended && count < maxBlockInstructions && pc + 1 < 4096) {
+        Chip8::Instruction in = Chip8::Decode((chip.memory[pc] << 8) | chip.memory[pc + 1]);
+        const int32_t vx = regs + in.x;
+        const int32_t vy = regs + in.y;
+        uint16_t next = pc + 2;
+        bool native = true;
+
+        switch (in.handler) {
+        case Chip8::H_0nnn:
+            if (in.nnn == 0x0E0) native = false;                         // 00E0 clears display
+            else if (in.nnn == 0x0EE) { native = false; ended = true; }  // 00EE returns
+            break;                                                       // Other 0NNN are ignored
+        case Chip8::H_1nnn:
+            e.Store16Imm(pcOff, in.nnn);
+            ended = true;
+            break;
+        case Chip8::H_3xnn:
+        case Chip8::H_4xnn:
+            e.Load8(EAX, vx);
+            e.Byte(0x3D); e.Imm32(in.nn);                                // cmp eax, nn
+            skipIf(in.handler == Chip8::H_3xnn ? 0x44 : 0x45, next);     // cmove / cmovne
+            ended = true;
+            break;
+        case Chip8::H_5xy0:
+        case Chip8::H_9xy0:
+            e.Load8(EAX, vx);
+            e.Load8(ECX, vy);
+            e.RegOp(0x39, EAX, ECX);                                     // cmp eax, ecx
+            skipIf(in.handler == Chip8::H_5xy0 ? 0x44 : 0x45, next);
+            ended = true;
+            break;
+        case Chip8::H_6xnn:
+            e.Store8Imm(vx, in.nn);
+            break;
+        case Chip8::H_7xnn:
+            e.Byte(0x80); e.Mem(0, vx); e.Byte(in.nn);                   // add byte [vx], nn
+            break;
+        case Chip8::H_8xy0:
+            e.Load8(EAX, vy);
+            e.Store8(EAX, vx);
+            break;
+        case Chip8::H_8xy1:
+        case Chip8::H_8xy2:
+        case Chip8::H_8xy3:
+            e.Load8(EAX, vy);
+            e.Byte(in.handler == Chip8::H_8xy1 ? 0x08 : in.handler == Chip8::H_8xy2 ? 0x20 : 0x30);  // or/and/xor byte [vx], al
+            e.Mem(EAX, vx);
+            break;
+        case Chip8::H_8xy4:
+            e.Load8(EAX, vx);
+            e.Load8(ECX, vy);
+            e.RegOp(0x01, EAX, ECX);                                     // add eax, ecx
+            e.Store8(EAX, vx);
+            e.Byte(0xC1); e.Byte(0xE8); e.Byte(8);                       // shr eax, 8 (carry)
+            e.Store8(EAX, vf);
+            break;
+        case Chip8::H_8xy5:
+            e.Load8(EAX, vx);
+            e.Load8(ECX, vy);
+            e.RegOp(0x39, EAX, ECX);                                     // cmp eax, ecx
+            e.Byte(0x0F); e.Byte(0x93); e.Byte(0xC2);                    // setae dl
+            e.RegOp(0x29, EAX, ECX);                                     // sub eax, ecx
+            e.Store8(EAX, vx);
+            e.Store8(EDX, vf);
+            break;
+        case Chip8::H_8xy6:
+            e.Load8(EAX, vx);
+            e.RegOp(0x89, EDX, EAX);                                     // mov edx, eax
+            e.Byte(0x83); e.Byte(0xE2); e.Byte(1);                       // and edx, 1
+            e.Byte(0xD1); e.Byte(0xE8);                                  // shr eax, 1
+            e.Store8(EAX, vx);
+            e.Store8(EDX, vf);
+            break;
+        case Chip8::H_8xy7:
+            e.Load8(EAX, vx);
+            e.Load8(ECX, vy);
+            e.RegOp(0x39, ECX, EAX);                                     // cmp ecx, eax
+            e.Byte(0x0F); e.Byte(0x93); e.Byte(0xC2);                    // setae dl
+            e.RegOp(0x29, ECX, EAX);                                     // sub ecx, eax
+            e.Store8(ECX, vx);
+            e.Store8(EDX, vf);
+            break;
+        case Chip8::H_8xyE:
+            e.Load8(EAX, vx);
+            e.RegOp(0x89, EDX, EAX);                                     // mov edx, eax
+            e.Byte(0xC1); e.Byte(0xEA); e.Byte(7);                       // shr edx, 7
+            e.Byte(0xD1); e.Byte(0xE0);                                  // shl eax, 1
+            e.Store8(EAX, vx);
+            e.Store8(EDX, vf);
+            break;
+        case Chip8::H_Annn:
+            e.Store16Imm(indexOff, in.nnn);
+            break;
+        case Chip8::H_Fx07:
+            e.Load8(EAX, delayOff);
+            e.Store8(EAX, vx);
+            break;
+        case Chip8::H_Fx15:
+        case Chip8::H_Fx18:
+            e.Load8(EAX, vx);
+            e.Store8(EAX, in.handler == Chip8::H_Fx15 ? delayOff : soundOff);
+            break;
+        case Chip8::H_Fx1E:
+            e.Load8(EAX, vx);
+            e.Byte(0x66); e.Byte(0x01); e.Mem(EAX, indexOff);            // add word [index], ax
+            break;
+        case Chip8::H_Fx29:
+            e.Load8(EAX, vx);
+            e.Byte(0x83); e.Byte(0xE0); e.Byte(0x0F);                    // and eax, 0xF
+            e.Byte(0x6B); e.Byte(0xC0); e.Byte(5);                       // imul eax, eax, 5
+            e.Byte(0x83); e.Byte(0xC0); e.Byte(0x50);                    // add eax, 0x50
+            e.Store16(EAX, indexOff);
+            break;
+        case Chip8::H_2nnn:
+        case Chip8::H_Bnnn:
+        case Chip8::H_Ex9E:
+        case Chip8::H_ExA1:
+        case Chip8::H_Fx0A:
+        case Chip8::H_Fx33:  // Writes memory, this block may be the one being overwritten
+        case Chip8::H_Fx55:
+            native = false;
+            ended = true;
+            break;
+        default:             // CXNN, DXYN, FX65, invalid opcodes
+            native = false;
+            break;
+        }
+
+        if (!native) {
+            callCycle(pc);
+        }
+        lastWasCycle = !native;
+        lastOpcode = in.opcode;
+        pc = next;
+        ++count;
+    }
+
+    if (count == 0) {
+        return nullptr;
+    }
+    if (!ended) {
+        e.Store16Imm(pcOff, pc);  // Fell off the end of the block (length limit)
+    }
+    if (!lastWasCycle) {
+        e.Store16Imm(opcodeOff, lastOpcode);
+    }
+    // Epilogue
+    e.Byte(0x48); e.Byte(0x83); e.Byte(0xC4); e.Byte(0x20);  // add rsp, 32
+    e.Byte(0x5B);                                   // pop rbx
+    e.Byte(0xC3);                                   // ret
+
+    if (codeUsed + e.bytes.size() > codeSize) {
+        Flush();  // Safe here: no block is running while we compile
+    }
+    uint8_t* fn = code + codeUsed;
+    std::memcpy(fn, e.bytes.data(), e.bytes.size());
+    codeUsed += e.bytes.size();
+
+    Block& block = blocks[address];
+    block.fn = reinterpret_cast<BlockFn>(fn);
+    block.bytes = pc - address;
+    block.instructions = count;
+    return &block;
+#else
+    (void)address;
+    return nullptr;
+#endif
+}
@@ -0,0 +1,382 @@
+#include "../include/Chip8Lanes.h"
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+template <int Lanes>
+void Chip8Lanes<Lanes>::Load(int lane, const Chip8& chip) {
+    for (int r = 0; r < 16; ++r) {
+        registers[r][lane] = chip.registers[r];
+    }
+    index[lane] = chip.index;
+    pc[lane] = chip.pc;
+    opcode[lane] = chip.opcode;
+    sp[lane] = chip.sp;
+    delayTimer[lane] = chip.delayTimer;
+    soundTimer[lane] = chip.soundTimer;
+    drawFlag[lane] = chip.drawFlag;
+    waitingForKey[lane] = chip.waitingForKey;
+    frameCount[lane] = chip.frameCount;
+    keypadReads[lane] = chip.keypadReads;
+    unknownOpcodes[lane] = chip.unknownOpcodes;
+    lastUnknownOpcode[lane] = chip.lastUnknownOpcode;
+    std::copy(std::begin(chip.stack), std::end(chip.stack), stack[lane]);
+    std::copy(std::begin(chip.keypad), std::end(chip.keypad), keypad[lane]);
+    std::copy(std::begin(chip.display), std::end(chip.display), display[lane]);
+    std::copy(std::begin(chip.dirtyRows), std::end(chip.dirtyRows), dirtyRows[lane]);
+    std::copy(std::begin(chip.memory), std::end(chip.memory), memory[lane]);
+    randGen[lane] = chip.randGen;
+}
+
+template <int Lanes>
+void Chip8Lanes<Lanes>::Store(int lane, Chip8& chip) const {
+    for (int r = 0; r < 16; ++r) {
+        chip.registers[r] = registers[r][lane];
+    }
+    chip.index = index[lane];
+    chip.pc = pc[lane];
+    chip.opcode = opcode[lane];
+    chip.sp = sp[lane];
+    chip.delayTimer = delayTimer[lane];
+    chip.soundTimer = soundTimer[lane];
+    chip.drawFlag = drawFlag[lane] != 0;
+    chip.waitingForKey = waitingForKey[lane] != 0;
+    chip.frameCount = frameCount[lane];
+    chip.keypadReads = keypadReads[lane];
+    chip.unknownOpcodes = unknownOpcodes[lane];
+    chip.lastUnknownOpcode = lastUnknownOpcode[lane];
+    std::copy(std::begin(stack[lane]), std::end(stack[lane]), chip.stack);
+    std::copy(std::begin(keypad[lane]), std::end(keypad[lane]), chip.keypad);
+    std::copy(std::begin(display[lane]), std::end(display[lane]), chip.display);
+    std::copy(std::begin(dirtyRows[lane]), std::end(dirtyRows[lane]), chip.dirtyRows);
+    std::copy(std::begin(memory[lane]), std::end(memory[lane]), chip.memory);
+    // The lane may have written anywhere (FX33/FX55 wrap past 0xFFF into the font and below 0x200)
+    chip.NotifyMemoryWrite(0, sizeof(chip.memory));
+    chip.randGen = randGen[lane];
+}
+
+template <int Lanes>
+void Chip8Lanes<Lanes>::Run(int cycles) {
+    for (int i = 0; i < cycles; ++i) {
+        Step();
+    }
+}
+
+template <int Lanes>
+void Chip8Lanes<Lanes>::TickTimers() {
+    for (int l = 0; l < Lanes; ++l) {
+        delayTimer[l] -= delayTimer[l] > 0 ? 1 : 0;
+        soundTimer[l] -= soundTimer[l] > 0 ? 1 : 0;
+        ++frameCount[l];
+    }
+}
+
+template <int Lanes>
+void Chip8Lanes<Lanes>::Step() {
+    // Fetch one opcode per lane (lanes may have modified their own code differently)
+    alignas(64) uint16_t fetched[Lanes];
+    for (int l = 0; l < Lanes; ++l) {
+        uint16_t addr = pc[l] & 0x0FFF;
+        fetched[l] = static_cast<uint16_t>((memory[l][addr] << 8) | memory[l][(addr + 1) & 0x0FFF]);
+    }
+
+    uint32_t pending = Lanes == 32 ? 0xFFFFFFFFu : (1u << Lanes) - 1;
+    while (pending) {
+        // Group every pending lane that fetched the same opcode as the first pending one
+        uint16_t op = fetched[std::countr_zero(pending)];
+        uint32_t group = 0;
+        for (int l = 0; l < Lanes; ++l) {
+            group |= static_cast<uint32_t>(fetched[l] == op) << l;
+        }
+        group &= pending;
+        Execute(op, group);
+        pending &= ~group;
+    }
+}
+
+/*
+* Lane masks are 0xFF/0xFFFF for lanes that run this opcode and 0 for the rest, so "value = active ? new : old"
+* becomes and/andnot/or (or a blend) over the whole lane array. Loops that can't be written like that
+* (per-lane memory, stack, keypad, RNG) just test the lane bit.
+*/
+template <int Lanes>
+void Chip8Lanes<Lanes>::Execute(uint16_t op, uint32_t group) {
+    const Chip8::Instruction in = Chip8::Decode(op);
+    const uint8_t x = in.x;
+    const uint8_t y = in.y;
+    alignas(64) uint8_t active[Lanes];
+    alignas(64) uint16_t active16[Lanes];
+    for (int l = 0; l < Lanes; ++l) {
+        active[l] = (group >> l) & 1 ? 0xFF : 0x00;
+        active16[l] = active[l] ? 0xFFFF : 0x0000;
+    }
+    auto lane = [group](int l) { return ((group >> l) & 1) != 0; };
+
+    for (int l = 0; l < Lanes; ++l) {
+        opcode[l] = static_cast<uint16_t>((op & active16[l]) | (opcode[l] & ~active16[l]));
+        pc[l] += active16[l] & 2;  // Increment PC early (some opcodes may change it)
+    }
+
+    uint8_t* vx = registers[x];
+    uint8_t* vy = registers[y];
+    uint8_t* vf = registers[0xF];
+    switch (in.handler) {
+    case Chip8::H_0nnn:
+        if (in.nnn == 0x0E0) {
+            for (int l = 0; l < Lanes; ++l) {
+                if (lane(l)) {
+                    for (int row = 0; row < 32; ++row) {
+                        dirtyRows[l][row] |= display[l][row];
+                        display[l][row] = 0;
+                    }
+                    drawFlag[l] = 1;
+                }
+            }
+        }
+        else if (in.nnn == 0x0EE) {
+            for (int l = 0; l < Lanes; ++l) {
+                if (lane(l) && sp[l] > 0) {
+                    --sp[l];
+                    pc[l] = stack[l][sp[l]];
+                }
+            }
+        }
+        break;
+    case Chip8::H_1nnn:
+        for (int l = 0; l < Lanes; ++l) {
+            pc[l] = static_cast<uint16_t>((in.nnn & active16[l]) | (pc[l] & ~active16[l]));
+        }
+        break;
+    case Chip8::H_2nnn:
+        for (int l = 0; l < Lanes; ++l) {
+            if (lane(l) && sp[l] < 16) {
+                stack[l][sp[l]] = pc[l];
+                ++sp[l];
+                pc[l] = in.nnn;
+            }
+        }
+        break;
+    case Chip8::H_3xnn:
+        for (int l = 0; l < Lanes; ++l) {
+            pc[l] += (vx[l] == in.nn ? active16[l] : 0) & 2;
+        }
+        break;
+    case Chip8::H_4xnn:
+        for (int l = 0; l < Lanes; ++l) {
+            pc[l] += (vx[l] != in.nn ? active16[l] : 0) & 2;
+        }
+        break;
+    case Chip8::H_5xy0:
+        for (int l = 0; l < Lanes; ++l) {
+            pc[l] += (vx[l] == vy[l] ? active16[l] : 0) & 2;
+        }
+        break;
+    case Chip8::H_6xnn:
+        for (int l = 0; l < Lanes; ++l) {
+            vx[l] = static_cast<uint8_t>((in.nn & active[l]) | (vx[l] & ~active[l]));
+        }
+        break;
+    case Chip8::H_7xnn:
+        for (int l = 0; l < Lanes; ++l) {
+            vx[l] += in.nn & active[l];
+        }
+        break;
+    case Chip8::H_8xy0:
+        for (int l = 0; l < Lanes; ++l) {
+            vx[l] = static_cast<uint8_t>((vy[l] & active[l]) | (vx[l] & ~active[l]));
+        }
+        break;
+    case Chip8::H_8xy1:
+        for (int l = 0; l < Lanes; ++l) {
+            vx[l] |= vy[l] & active[l];
+        }
+        break;
+    case Chip8::H_8xy2:
+        for (int l = 0; l < Lanes; ++l) {
+            vx[l] &= vy[l] | ~active[l];
+        }
+        break;
+    case Chip8::H_8xy3:
+        for (int l = 0; l < Lanes; ++l) {
+            vx[l] ^= vy[l] & active[l];
+        }
+        break;
+    // Flag opcodes: compute from the old values, write VX, then VF last (same order as Chip8)
+    case Chip8::H_8xy4:
+        for (int l = 0; l < Lanes; ++l) {
+            uint16_t sum = vx[l] + vy[l];
+            uint8_t flag = sum > 0xFF ? 1 : 0;
+            vx[l] = static_cast<uint8_t>((sum & active[l]) | (vx[l] & ~active[l]));
+            vf[l] = static_cast<uint8_t>((flag & active[l]) | (vf[l] & ~active[l]));
+        }
+        break;
+    case Chip8::H_8xy5:
+        for (int l = 0; l < Lanes; ++l) {
+            uint8_t flag = vx[l] >= vy[l] ? 1 : 0;
+            uint8_t result = vx[l] - vy[l];
+            vx[l] = static_cast<uint8_t>((result & active[l]) | (vx[l] & ~active[l]));
+            vf[l] = static_cast<uint8_t>((flag & active[l]) | (vf[l] & ~active[l]));
+        }
+        break;
+    case Chip8::H_8xy6:
+        for (int l = 0; l < Lanes; ++l) {
+            uint8_t flag = vx[l] & 0x1;
+            uint8_t result = vx[l] >> 1;
+            vx[l] = static_cast<uint8_t>((result & active[l]) | (vx[l] & ~active[l]));
+            vf[l] = static_cast<uint8_t>((flag & active[l]) | (vf[l] & ~active[l]));
+        }
+        break;
+    case Chip8::H_8xy7:
+        for (int l = 0; l < Lanes; ++l) {
+            uint8_t flag = vy[l] >= vx[l] ? 1 : 0;
+            uint8_t result = vy[l] - vx[l];
+            vx[l] = static_cast<uint8_t>((result & active[l]) | (vx[l] & ~active[l]));
+            vf[l] = static_cast<uint8_t>((flag & active[l]) | (vf[l] & ~active[l]));
+        }
+        break;
+    case Chip8::H_8xyE:
+        for (int l = 0; l < Lanes; ++l) {
+            uint8_t flag = (vx[l] & 0x80) >> 7;
+            uint8_t result = static_cast<uint8_t>(vx[l] << 1);
+            vx[l] = static_cast<uint8_t>((result & active[l]) | (vx[l] & ~active[l]));
+            vf[l] = static_cast<uint8_t>((flag & active[l]) | (vf[l] & ~active[l]));
+        }
+        break;
+    case Chip8::H_9xy0:
+        for (int l = 0; l < Lanes; ++l) {
+            pc[l] += (vx[l] != vy[l] ? active16[l] : 0) & 2;
+        }
+        break;
+    case Chip8::H_Annn:
+        for (int l = 0; l < Lanes; ++l) {
+            index[l] = static_cast<uint16_t>((in.nnn & active16[l]) | (index[l] & ~active16[l]));
+        }
+        break;
+    case Chip8::H_Bnnn:
+        for (int l = 0; l < Lanes; ++l) {
+            uint16_t target = in.nnn + registers[0][l];
+            pc[l] = static_cast<uint16_t>((target & active16[l]) | (pc[l] & ~active16[l]));
+        }
+        break;
+    case Chip8::H_Cxnn:
+        for (int l = 0; l < Lanes; ++l) {
+            if (lane(l)) {
+                vx[l] = randGen[l].NextByte() & in.nn;
+            }
+        }
+        break;
+    case Chip8::H_Dxyn:
+        for (int l = 0; l < Lanes; ++l) {
+            if (!lane(l)) {
+                continue;
+            }
+            uint8_t xPos = vx[l] % 64;
+            uint8_t yPos = vy[l] % 32;
+            uint64_t collision = 0;
+            for (int row = 0; row < in.n && yPos + row < 32; ++row) {
+                uint64_t spriteRow = (static_cast<uint64_t>(memory[l][(index[l] + row) & 0x0FFF]) << 56) >> xPos;
+                collision |= display[l][yPos + row] & spriteRow;
+                display[l][yPos + row] ^= spriteRow;
+                dirtyRows[l][yPos + row] |= spriteRow;
+            }
+            vf[l] = collision ? 1 : 0;
+            drawFlag[l] = 1;
+        }
+        break;
+    case Chip8::H_Ex9E:
+        for (int l = 0; l < Lanes; ++l) {
+            pc[l] += (keypad[l][vx[l] & 0xF] ? active16[l] : 0) & 2;
+            keypadReads[l] += active[l] & 1;
+        }
+        break;
+    case Chip8::H_ExA1:
+        for (int l = 0; l < Lanes; ++l) {
+            pc[l] += (!keypad[l][vx[l] & 0xF] ? active16[l] : 0) & 2;
+            keypadReads[l] += active[l] & 1;
+        }
+        break;
+    case Chip8::H_Fx07:
+        for (int l = 0; l < Lanes; ++l) {
+            vx[l] = static_cast<uint8_t>((delayTimer[l] & active[l]) | (vx[l] & ~active[l]));
+        }
+        break;
+    case Chip8::H_Fx0A:
+        for (int l = 0; l < Lanes; ++l) {
+            if (!lane(l)) {
+                continue;
+            }
+            ++keypadReads[l];
+            waitingForKey[l] = 1;
+            for (uint8_t key = 0; key < 16; ++key) {
+                if (keypad[l][key]) {
+                    vx[l] = key;
+                    waitingForKey[l] = 0;
+                    break;
+                }
+            }
+            if (waitingForKey[l]) {
+                pc[l] -= 2;
+            }
+        }
+        break;
+    case Chip8::H_Fx15:
+        for (int l = 0; l < Lanes; ++l) {
+            delayTimer[l] = static_cast<uint8_t>((vx[l] & active[l]) | (delayTimer[l] & ~active[l]));
+        }
+        break;
+    case Chip8::H_Fx18:
+        for (int l = 0; l < Lanes; ++l) {
+            soundTimer[l] = static_cast<uint8_t>((vx[l] & active[l]) | (soundTimer[l] & ~active[l]));
+        }
+        break;
+    case Chip8::H_Fx1E:
+        for (int l = 0; l < Lanes; ++l) {
+            index[l] += vx[l] & active16[l];
+        }
+        break;
+    case Chip8::H_Fx29:
+        for (int l = 0; l < Lanes; ++l) {
+            uint16_t font = 0x050 + (vx[l] & 0xF) * 5;
+            index[l] = static_cast<uint16_t>((font & active16[l]) | (index[l] & ~active16[l]));
+        }
+        break;
+    case Chip8::H_Fx33:
+        for (int l = 0; l < Lanes; ++l) {
+            if (lane(l)) {
+                uint8_t value = vx[l];
+                memory[l][index[l] & 0x0FFF] = value / 100;
+                memory[l][(index[l] + 1) & 0x0FFF] = (value / 10) % 10;
+                memory[l][(index[l] + 2) & 0x0FFF] = value % 10;
+            }
+        }
+        break;
+    case Chip8::H_Fx55:
+        for (int l = 0; l < Lanes; ++l) {
+            if (lane(l)) {
+                for (int i = 0; i <= x; ++i) {
+                    memory[l][(index[l] + i) & 0x0FFF] = registers[i][l];
+                }
+            }
+        }
+        break;
+    case Chip8::H_Fx65:
+        for (int l = 0; l < Lanes; ++l) {
+            if (lane(l)) {
+                for (int i = 0; i <= x; ++i) {
+                    registers[i][l] = memory[l][(index[l] + i) & 0x0FFF];
+                }
+            }
+        }
+        break;
+    default:
+        // Invalid opcode: nothing runs, it's only counted (same as Chip8::OP_NULL)
+        for (int l = 0; l < Lanes; ++l) {
+            unknownOpcodes[l] += active[l] & 1;
+            lastUnknownOpcode[l] = static_cast<uint16_t>((op & active16[l]) | (lastUnknownOpcode[l] & ~active16[l]));
+        }
+        break;
+    }
+}
+
+template class Chip8Lanes<8>;
+template class Chip8Lanes<16>;
@@ -0,0 +1,205 @@
+#include "../include/DisplayExpand.h"
+#include <atomic>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CHIP8_EXPAND_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CHIP8_TARGET_AVX2
+#else
+#define CHIP8_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/*
+* Every kernel expands one source row into the first output line and then copies that line (scale - 1) times,
+* so only the horizontal part (1 bit -> scale pixels) is vectorized.
+*/
+using LineKernel = void (*)(uint64_t bits, uint32_t* line, uint32_t onColor, uint32_t offColor, int scale);
+
+static void ExpandLineScalar(uint64_t bits, uint32_t* line, uint32_t onColor, uint32_t offColor, int scale) {
+    for (int x = 0; x < 64; ++x) {
+        uint32_t color = (bits >> (63 - x)) & 1 ? onColor : offColor;
+        for (int s = 0; s < scale; ++s) {
+            *line++ = color;
+        }
+    }
+}
+
+#ifdef CHIP8_EXPAND_X86
+// 4 pixels at a time: each lane tests one bit of a nibble and selects on/off with and/andnot/or
+static void ExpandLineSSE2(uint64_t bits, uint32_t* line, uint32_t onColor, uint32_t offColor, int scale) {
+    const __m128i laneBits = _mm_set_epi32(1, 2, 4, 8);  // Lane 0 = leftmost pixel = highest bit of the nibble
+    const __m128i on = _mm_set1_epi32(static_cast<int>(onColor));
+    const __m128i off = _mm_set1_epi32(static_cast<int>(offColor));
+
+    for (int group = 0; group < 16; ++group) {
+        int nibble = static_cast<int>((bits >> (60 - group * 4)) & 0xF);
+        __m128i mask = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(nibble), laneBits), laneBits);
+        __m128i colors = _mm_or_si128(_mm_and_si128(mask, on), _mm_andnot_si128(mask, off));
+
+        if (scale == 1) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(line), colors);
+            line += 4;
+        }
+        else if (scale == 2) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(line), _mm_unpacklo_epi32(colors, colors));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(line + 4), _mm_unpackhi_epi32(colors, colors));
+            line += 8;
+        }
+        else if (scale >= 4) {
+            // Splat each pixel; the last store may overlap the previous one, which is fine since it writes the same color
+            alignas(16) uint32_t pixel[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(pixel), colors);
+            for (int i = 0; i < 4; ++i) {
+                __m128i splat = _mm_set1_epi32(static_cast<int>(pixel[i]));
+                for (int s = 0; s + 4 <= scale; s += 4) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(line + s), splat);
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(line + scale - 4), splat);
+                line += scale;
+            }
+        }
+        else {
+            alignas(16) uint32_t pixel[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(pixel), colors);
+            for (int i = 0; i < 4; ++i) {
+                for (int s = 0; s < scale; ++s) {
+                    *line++ = pixel[i];
+                }
+            }
+        }
+    }
+}
+
+// 8 pixels at a time from one byte of the row; scales below 8 reuse the SSE2 kernel
+CHIP8_TARGET_AVX2 static void ExpandLineAVX2(uint64_t bits, uint32_t* line, uint32_t onColor, uint32_t offColor, int scale) {
+    if (scale != 1 && scale < 8) {
+        ExpandLineSSE2(bits, line, onColor, offColor, scale);
+        return;
+    }
+    const __m256i laneBits = _mm256_set_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i on = _mm256_set1_epi32(static_cast<int>(onColor));
+    const __m256i off = _mm256_set1_epi32(static_cast<int>(offColor));
+
+    for (int group = 0; group < 8; ++group) {
+        int byte = static_cast<int>((bits >> (56 - group * 8)) & 0xFF);
+        __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(byte), laneBits), laneBits);
+        __m256i colors = _mm256_blendv_epi8(off, on, mask);
+
+        if (scale == 1) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(line), colors);
+            line += 8;
+        }
+        else {
+            alignas(32) uint32_t pixel[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(pixel), colors);
+            for (int i = 0; i < 8; ++i) {
+                __m256i splat = _mm256_set1_epi32(static_cast<int>(pixel[i]));
+                for (int s = 0; s + 8 <= scale; s += 8) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(line + s), splat);
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(line + scale - 8), splat);
+                line += scale;
+            }
+        }
+    }
+}
+
+static bool CpuHasAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {  // OS must save the YMM registers
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+static LineKernel KernelFor(ExpandPath path) {
+    switch (path) {
+#ifdef CHIP8_EXPAND_X86
+    case ExpandPath::AVX2: return CpuHasAVX2() ? &ExpandLineAVX2 : nullptr;
+    case ExpandPath::SSE2: return &ExpandLineSSE2;  // Baseline on x86-64 (and on /arch:SSE2 32-bit builds)
+#endif
+    case ExpandPath::Scalar: return &ExpandLineScalar;
+    default: return nullptr;
+    }
+}
+
+/*
+* The kernel is read by whichever thread presents (EmulatorThread, frontends) and can be changed by SetExpandPath from another,
+* so it's an atomic. It's constant-initialized (nullptr = not picked yet, no dynamic initializer) and the CPU is only checked
+* on first use: an ExpandDisplay call from another file's static constructor can't run before the kernel is set up.
+* The path is worked out from the kernel itself, so the two can't disagree.
+*/
+static std::atomic<LineKernel> activeKernel{ nullptr };
+
+// The kernel in use, picking the best one the CPU supports the first time
+static LineKernel ResolveKernel() {
+    LineKernel kernel = activeKernel.load();
+    if (kernel) {
+        return kernel;
+    }
+    const ExpandPath preferred[] = { ExpandPath::AVX2, ExpandPath::SSE2, ExpandPath::Scalar };
+    for (ExpandPath path : preferred) {
+        LineKernel best = KernelFor(path);
+        if (!best) {
+            continue;
+        }
+        // Another thread (or SetExpandPath) may have got there first, then keep its choice
+        LineKernel expected = nullptr;
+        if (activeKernel.compare_exchange_strong(expected, best)) {
+            return best;
+        }
+        return expected;
+    }
+    return &ExpandLineScalar;
+}
+
+void ExpandDisplay(const uint64_t rows[32], uint32_t* pixels, int pitch, uint32_t onColor, uint32_t offColor, int scale) {
+    LineKernel kernel = ResolveKernel();
+    const size_t lineBytes = static_cast<size_t>(64 * scale) * sizeof(uint32_t);
+    for (int y = 0; y < 32; ++y) {
+        uint32_t* line = pixels + static_cast<size_t>(y) * scale * pitch;
+        kernel(rows[y], line, onColor, offColor, scale);
+        for (int s = 1; s < scale; ++s) {
+            std::memcpy(line + static_cast<size_t>(s) * pitch, line, lineBytes);
+        }
+    }
+}
+
+ExpandPath GetExpandPath() {
+    LineKernel kernel = ResolveKernel();
+#ifdef CHIP8_EXPAND_X86
+    if (kernel == &ExpandLineAVX2) {
+        return ExpandPath::AVX2;
+    }
+    if (kernel == &ExpandLineSSE2) {
+        return ExpandPath::SSE2;
+    }
+#endif
+    return ExpandPath::Scalar;
+}
+
+bool SetExpandPath(ExpandPath path) {
+    LineKernel kernel = KernelFor(path);
+    if (!kernel) {
+        return false;
+    }
+    activeKernel.store(kernel);
+    return true;
+}
@@ -0,0 +1,140 @@
+#include "../include/EmulatorThread.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+using Clock = std::chrono::steady_clock;
+
+EmulatorThread::EmulatorThread(Chip8& chip, int runAheadFrames) : chip(chip), runAhead(runAheadFrames) {
+}
+
+EmulatorThread::~EmulatorThread() {
+    Stop();
+}
+
+void EmulatorThread::Start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    thread = std::thread(&EmulatorThread::Loop, this);
+}
+
+void EmulatorThread::Stop() {
+    running.store(false);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+bool EmulatorThread::PushKey(uint8_t key, bool pressed) {
+    return input.TryPush({ Clock::now().time_since_epoch().count(), static_cast<uint8_t>(key & 0xF), pressed });
+}
+
+bool EmulatorThread::LatestFrame(const Frame*& frame) {
+    if (!frames.Update()) {
+        return false;
+    }
+    frame = &frames.Front();
+    return true;
+}
+
+EmulatorThread::InputLatency EmulatorThread::GetInputLatency() const {
+    InputLatency latency;
+    latency.samples = latencySamples.load(std::memory_order_relaxed);
+    auto toMs = [](int64_t ticks) { return std::chrono::duration<double, std::milli>(Clock::duration(ticks)).count(); };
+    if (latency.samples > 0) {
+        latency.meanMs = toMs(latencyTotal.load(std::memory_order_relaxed)) / latency.samples;
+    }
+    latency.maxMs = toMs(latencyMax.load(std::memory_order_relaxed));
+    return latency;
+}
+
+void EmulatorThread::Loop() {
+    const auto frameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / 60.0));
+    const int64_t frameTicks = frameTime.count();
+    auto deadline = Clock::now();
+    PlacedEvent events[maxEventsPerFrame];
+    while (running.load(std::memory_order_relaxed)) {
+        // Events from the last 1/60s are replayed at the same relative position in this frame
+        const int ipf = chip.instructionsPerFrame;
+        const int64_t windowStart = deadline.time_since_epoch().count() - frameTicks;
+        int count = 0;
+        KeyEvent event;
+        while (count < maxEventsPerFrame && input.TryPop(event)) {
+            int64_t offset = std::clamp<int64_t>(event.time - windowStart, 0, frameTicks - 1);
+            events[count++] = { static_cast<int>(offset * ipf / frameTicks), event };
+        }
+        // Same timestamp order = same cycle order (the queue is already in push order)
+        std::stable_sort(events, events + count, [](const PlacedEvent& a, const PlacedEvent& b) { return a.cycle < b.cycle; });
+        RunFrame(deadline.time_since_epoch().count(), frameTicks, events, count);
+
+        runAhead.Run(chip);
+
+        Frame& out = frames.Back();
+        std::copy(runAhead.Display(), runAhead.Display() + 32, out.display);
+        out.frameCount = chip.frameCount;
+        out.soundOn = runAhead.SoundOn();
+        out.runAheadMicroseconds = static_cast<uint32_t>(runAhead.LastMicroseconds());
+        out.idle = chip.idle;
+        frames.Publish();
+
+        deadline += frameTime;
+        auto now = Clock::now();
+        if (now > deadline) {
+            lateFrames.fetch_add(1, std::memory_order_relaxed);
+            if (now - deadline > 4 * frameTime) {
+                deadline = now;  // Far behind (debugger, machine asleep): don't try to catch up in a burst
+            }
+            continue;
+        }
+        std::this_thread::sleep_until(deadline);
+    }
+}
+
+/*
+* Runs one emulated frame, stopping at each event's instruction to apply it (RunCycles up to it, like the movie replayer).
+* While a latency sample is open the frame is stepped one instruction at a time so the first keypad read is caught exactly;
+* the emulated time of instruction n is frameStart + n / instructionsPerFrame of a frame.
+*/
+void EmulatorThread::RunFrame(int64_t frameStart, int64_t frameTicks, PlacedEvent* events, int count) {
+    const int ipf = chip.instructionsPerFrame;
+    const uint64_t frame = chip.frameCount;
+    int next = 0;
+    while (chip.frameCount == frame) {
+        while (next < count && events[next].cycle <= chip.frameCycles) {
+            const KeyEvent& event = events[next++].event;
+            chip.keypad[event.key] = event.pressed ? 1 : 0;
+            if (!latencyPending) {
+                latencyPending = true;
+                latencyEventTime = event.time;
+                latencyFrame = frame;
+            }
+        }
+
+        if (latencyPending) {
+            int cycle = chip.frameCycles;
+            uint64_t reads = chip.keypadReads;
+            chip.RunCycles(1);
+            if (chip.keypadReads != reads) {
+                int64_t readTime = frameStart + cycle * frameTicks / ipf;
+                int64_t latency = std::max<int64_t>(readTime - latencyEventTime, 0);
+                latencySamples.fetch_add(1, std::memory_order_relaxed);
+                latencyTotal.fetch_add(latency, std::memory_order_relaxed);
+                if (latency > latencyMax.load(std::memory_order_relaxed)) {
+                    latencyMax.store(latency, std::memory_order_relaxed);  // Only this thread writes it
+                }
+                latencyPending = false;
+            }
+        }
+        else if (next < count) {
+            chip.RunCycles(events[next].cycle - chip.frameCycles);
+        }
+        else {
+            chip.RunUntilFrame(ipf);
+        }
+        chip.drawFlag = false;
+    }
+    if (latencyPending && chip.frameCount - latencyFrame > 30) {
+        latencyPending = false;  // The ROM isn't reading the keypad (e.g. title screen animation), stop single-stepping
+    }
+}
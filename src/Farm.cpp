@@ -0,0 +1,191 @@
+#include "../include/Farm.h"
+#include <iostream>
+#include <thread>
+
+/*
+* Chase-Lev work-stealing deque of job ids (fixed capacity, no resizing).
+* The owning worker pushes and pops at the bottom, thieves take from the top; only the last element needs a CAS.
+* A job id lives in exactly one deque at a time, so a capacity of (number of jobs) can never overflow.
+*/
+class Farm::WorkDeque {
+public:
+    static constexpr uint32_t empty = 0xFFFFFFFF;
+
+    explicit WorkDeque(size_t jobs) {
+        size_t capacity = 1;
+        while (capacity < jobs) {
+            capacity <<= 1;
+        }
+        mask = capacity - 1;
+        buffer = std::make_unique<std::atomic<uint32_t>[]>(capacity);
+    }
+
+    // Owner only
+    void Push(uint32_t job) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        buffer[b & mask].store(job, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);  // Publishes the job (and everything the owner wrote to its instance) to thieves
+    }
+
+    // Owner only
+    uint32_t Pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);  // Was empty
+            return empty;
+        }
+        uint32_t job = buffer[b & mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last element: race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                job = empty;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    // Any thread
+    uint32_t Steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return empty;
+        }
+        uint32_t job = buffer[t & mask].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return empty;  // Lost the race, the caller tries another victim
+        }
+        return job;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top{ 0 };
+    alignas(64) std::atomic<int64_t> bottom{ 0 };
+    std::unique_ptr<std::atomic<uint32_t>[]> buffer;
+    size_t mask = 0;
+};
+
+Farm::Farm(unsigned threads) : threadCount(threads) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+}
+
+Farm::~Farm() = default;
+
+RomImage Farm::LoadRomImage(const std::string& filename) {
+    RomImage image = RomCache::Shared().Load(filename);
+    if (!image) {
+        std::cerr << "Failed to open ROM: " << filename << std::endl;
+    }
+    return image;
+}
+
+size_t Farm::Add(FarmJob job) {
+    jobs.push_back(std::move(job));
+    return jobs.size() - 1;
+}
+
+void Farm::Run() {
+    // Set every instance up front (all of them stay resident until Run returns)
+    instances.clear();
+    instances.resize(jobs.size());
+    results.assign(jobs.size(), FarmResult{});
+    deques.clear();
+    for (unsigned i = 0; i < threadCount; ++i) {
+        deques.push_back(std::make_unique<WorkDeque>(jobs.size()));
+    }
+
+    size_t runnable = 0;
+    for (size_t id = 0; id < jobs.size(); ++id) {
+        Instance& instance = instances[id];
+        instance.chip = std::make_unique<Chip8>(jobs[id].seed);
+        instance.chip->instructionsPerFrame = jobs[id].instructionsPerFrame;
+        if (!jobs[id].rom || !instance.chip->LoadROM(jobs[id].rom)) {
+            continue;  // results[id].loaded stays false
+        }
+        results[id].loaded = true;
+        if (jobs[id].frames == 0) {
+            Finish(id);  // Nothing to run (RunFrame always runs at least one frame)
+            continue;
+        }
+        // Deal the jobs round-robin; threads aren't running yet so pushing to every deque is safe
+        deques[runnable % threadCount]->Push(static_cast<uint32_t>(id));
+        ++runnable;
+    }
+    remaining.store(runnable);
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&Farm::Worker, this, i);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    instances.clear();  // Results are copied out, free the instances
+}
+
+void Farm::Worker(unsigned self) {
+    WorkDeque& own = *deques[self];
+    unsigned victim = self;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        uint32_t id = own.Pop();
+        for (unsigned attempt = 0; id == WorkDeque::empty && attempt < threadCount; ++attempt) {
+            victim = (victim + 1) % threadCount;
+            if (victim != self) {
+                id = deques[victim]->Steal();
+            }
+        }
+        if (id == WorkDeque::empty) {
+            std::this_thread::yield();  // Everything left is being run by other workers
+            continue;
+        }
+        if (RunFrame(id)) {
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        else {
+            own.Push(id);
+        }
+    }
+}
+
+bool Farm::RunFrame(size_t id) {
+    const FarmJob& job = jobs[id];
+    Instance& instance = instances[id];
+    Chip8& chip = *instance.chip;
+
+    while (instance.nextInput < job.input.size() && job.input[instance.nextInput].frame <= chip.frameCount) {
+        const FarmInput& event = job.input[instance.nextInput++];
+        chip.keypad[event.key & 0xF] = event.pressed ? 1 : 0;
+    }
+    uint64_t frame = chip.frameCount;
+    while (chip.frameCount == frame) {
+        instance.instructions += chip.RunUntilFrame(job.instructionsPerFrame);
+        chip.drawFlag = false;
+    }
+    if (chip.frameCount < job.frames) {
+        return false;
+    }
+    Finish(id);
+    return true;
+}
+
+void Farm::Finish(size_t id) {
+    const Instance& instance = instances[id];
+    const Chip8& chip = *instance.chip;
+    FarmResult& result = results[id];  // Only one thread touches this slot
+    result.frames = chip.frameCount;
+    result.instructions = instance.instructions;
+    result.pc = chip.pc;
+    result.index = chip.index;
+    std::copy(std::begin(chip.registers), std::end(chip.registers), result.registers);
+    result.displayHash = chip.DisplayHash();
+}
@@ -0,0 +1,158 @@
+#include "../include/Movie.h"
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+bool Movie::Save(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write movie: " << filename << std::endl;
+        return false;
+    }
+    file << "chip8-movie 1\n"
+        << "seed " << seed << "\n"
+        << "ipf " << instructionsPerFrame << "\n"
+        << "frames " << frames << "\n";
+    for (const MovieEvent& event : events) {
+        file << "key " << event.frame << " " << event.cycle << " " << "0123456789ABCDEF"[event.key & 0xF] << " " << (event.pressed ? "down" : "up") << "\n";
+    }
+    char hex[32];
+    for (const MovieHash& entry : hashes) {
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(entry.hash));
+        file << "hash " << entry.frame << " " << hex << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+bool Movie::Load(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open movie: " << filename << std::endl;
+        return false;
+    }
+    std::string line;
+    if (!std::getline(file, line) || line != "chip8-movie 1") {
+        std::cerr << "Not a chip8 movie (or unsupported version): " << filename << std::endl;
+        return false;
+    }
+    *this = Movie{};
+    int lineNumber = 1;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::istringstream fields(line);
+        std::string kind;
+        if (!(fields >> kind)) {
+            continue;
+        }
+        bool ok = false;
+        if (kind == "seed") {
+            ok = static_cast<bool>(fields >> seed);
+        }
+        else if (kind == "ipf") {
+            ok = static_cast<bool>(fields >> instructionsPerFrame) && instructionsPerFrame > 0;
+        }
+        else if (kind == "frames") {
+            ok = static_cast<bool>(fields >> frames);
+        }
+        else if (kind == "key") {
+            MovieEvent event;
+            std::string key, state;
+            ok = (fields >> event.frame >> event.cycle >> key >> state) && key.size() == 1 && std::isxdigit(static_cast<unsigned char>(key[0])) && (state == "down" || state == "up");
+            if (ok) {
+                event.key = static_cast<uint8_t>(std::stoi(key, nullptr, 16));
+                event.pressed = state == "down";
+                events.push_back(event);
+            }
+        }
+        else if (kind == "hash") {
+            MovieHash entry;
+            ok = static_cast<bool>(fields >> entry.frame >> std::hex >> entry.hash);
+            if (ok) {
+                hashes.push_back(entry);
+            }
+        }
+        if (!ok) {
+            std::cerr << "Bad movie line " << lineNumber << ": " << line << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+MovieRecorder::MovieRecorder(const Chip8& chip) {
+    movie.seed = chip.rngSeed;
+    movie.instructionsPerFrame = chip.instructionsPerFrame;
+}
+
+void MovieRecorder::Update(const Chip8& chip) {
+    if (chip.frameCount > movie.frames) {
+        movie.frames = chip.frameCount;
+        // The hash is only comparable when we're exactly on the frame boundary (nothing of the next frame has run yet)
+        if (chip.frameCycles == 0) {
+            movie.hashes.push_back({ chip.frameCount, chip.DisplayHash() });
+        }
+    }
+    for (uint8_t key = 0; key < 16; ++key) {
+        uint8_t pressed = chip.keypad[key] ? 1 : 0;
+        if (pressed != keys[key]) {
+            keys[key] = pressed;
+            movie.events.push_back({ chip.frameCount, static_cast<uint16_t>(chip.frameCycles), key, pressed != 0 });
+        }
+    }
+}
+
+/*
+* Runs whole frames with RunUntilFrame, except when a key changes in the middle of a frame:
+* then RunCycles stops exactly at the recorded instruction, the key is applied, and the frame continues.
+*/
+ReplayResult ReplayMovie(std::span<const uint8_t> rom, const Movie& movie) {
+    ReplayResult result;
+    auto chip = std::make_unique<Chip8>(movie.seed);
+    chip->instructionsPerFrame = movie.instructionsPerFrame;
+    if (!chip->LoadROM(rom)) {
+        return result;
+    }
+    result.loaded = true;
+
+    const int ipf = movie.instructionsPerFrame;
+    size_t nextEvent = 0;
+    size_t nextHash = 0;
+    while (chip->frameCount < movie.frames) {
+        while (nextEvent < movie.events.size()
+            && (movie.events[nextEvent].frame < chip->frameCount
+                || (movie.events[nextEvent].frame == chip->frameCount && movie.events[nextEvent].cycle <= chip->frameCycles))) {
+            const MovieEvent& event = movie.events[nextEvent++];
+            chip->keypad[event.key & 0xF] = event.pressed ? 1 : 0;
+        }
+
+        uint64_t frame = chip->frameCount;
+        if (nextEvent < movie.events.size() && movie.events[nextEvent].frame == frame && movie.events[nextEvent].cycle < ipf) {
+            result.instructions += chip->RunCycles(movie.events[nextEvent].cycle - chip->frameCycles);
+        }
+        else {
+            result.instructions += chip->RunUntilFrame(ipf);
+        }
+        chip->drawFlag = false;
+
+        if (chip->frameCount != frame) {
+            while (nextHash < movie.hashes.size() && movie.hashes[nextHash].frame < chip->frameCount) {
+                ++nextHash;  // Frames the recorder couldn't hash (it wasn't called on their boundary)
+            }
+            if (nextHash < movie.hashes.size() && movie.hashes[nextHash].frame == chip->frameCount) {
+                ++result.hashesChecked;
+                if (movie.hashes[nextHash].hash != chip->DisplayHash()) {
+                    if (result.mismatches++ == 0) {
+                        result.firstMismatch = chip->frameCount;
+                    }
+                }
+                ++nextHash;
+            }
+        }
+    }
+    result.frames = chip->frameCount;
+    result.displayHash = chip->DisplayHash();
+    return result;
+}
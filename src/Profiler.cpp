@@ -0,0 +1,125 @@
+#include "../include/Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+static const char* const handlerNames[] = {
+    "OP_0nnn", "OP_1nnn", "OP_2nnn", "OP_3xnn", "OP_4xnn", "OP_5xy0", "OP_6xnn", "OP_7xnn",
+    "OP_8xy0", "OP_8xy1", "OP_8xy2", "OP_8xy3", "OP_8xy4", "OP_8xy5", "OP_8xy6", "OP_8xy7", "OP_8xyE",
+    "OP_9xy0", "OP_Annn", "OP_Bnnn", "OP_Cxnn", "OP_Dxyn", "OP_Ex9E", "OP_ExA1",
+    "OP_Fx07", "OP_Fx0A", "OP_Fx15", "OP_Fx18", "OP_Fx1E", "OP_Fx29", "OP_Fx33", "OP_Fx55", "OP_Fx65",
+    "OP_NULL"
+};
+
+std::string JsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out += escaped;
+        }
+        else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+Chip8Profiler::Chip8Profiler(std::string name) : name(std::move(name)) {
+}
+
+const char* Chip8Profiler::HandlerName(uint8_t handler) {
+    static_assert(std::size(handlerNames) == Chip8::H_COUNT, "one name per handler id");
+    return handler < Chip8::H_COUNT ? handlerNames[handler] : "?";
+}
+
+void Chip8Profiler::Reset() {
+    std::fill(std::begin(handlerCounts), std::end(handlerCounts), 0);
+    std::fill(std::begin(addressCounts), std::end(addressCounts), 0);
+    std::fill(std::begin(addressHandlers), std::end(addressHandlers), 0);
+}
+
+void Chip8Profiler::Merge(const Chip8Profiler& other) {
+    for (int handler = 0; handler < Chip8::H_COUNT; ++handler) {
+        handlerCounts[handler] += other.handlerCounts[handler];
+    }
+    for (int address = 0; address < 4096; ++address) {
+        addressCounts[address] += other.addressCounts[address];
+        if (other.addressCounts[address]) {
+            addressHandlers[address] = other.addressHandlers[address];
+        }
+    }
+}
+
+uint64_t Chip8Profiler::Instructions() const {
+    return std::accumulate(std::begin(handlerCounts), std::end(handlerCounts), uint64_t{ 0 });
+}
+
+// Addresses that ran at least once, most executed first
+static std::vector<uint16_t> HotAddresses(const uint64_t (&counts)[4096]) {
+    std::vector<uint16_t> addresses;
+    for (uint16_t address = 0; address < 4096; ++address) {
+        if (counts[address]) {
+            addresses.push_back(address);
+        }
+    }
+    std::stable_sort(addresses.begin(), addresses.end(), [&](uint16_t a, uint16_t b) { return counts[a] > counts[b]; });
+    return addresses;
+}
+
+bool Chip8Profiler::WriteJson(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write profile: " << filename << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> handlers(Chip8::H_COUNT);
+    std::iota(handlers.begin(), handlers.end(), 0);
+    std::stable_sort(handlers.begin(), handlers.end(), [&](uint8_t a, uint8_t b) { return handlerCounts[a] > handlerCounts[b]; });
+
+    file << "{\"name\": " << JsonString(name) << ", \"instructions\": " << Instructions() << ", \"handlers\": [";
+    bool first = true;
+    for (uint8_t handler : handlers) {
+        if (handlerCounts[handler]) {
+            file << (first ? "" : ", ") << "{\"handler\": \"" << handlerNames[handler] << "\", \"count\": " << handlerCounts[handler] << "}";
+            first = false;
+        }
+    }
+    file << "], \"addresses\": [";
+    first = true;
+    char address[8];
+    for (uint16_t hot : HotAddresses(addressCounts)) {
+        std::snprintf(address, sizeof(address), "0x%03X", hot);
+        file << (first ? "" : ", ") << "{\"address\": \"" << address << "\", \"handler\": \"" << HandlerName(addressHandlers[hot]) << "\", \"count\": " << addressCounts[hot] << "}";
+        first = false;
+    }
+    file << "]}\n";
+    return static_cast<bool>(file);
+}
+
+bool Chip8Profiler::WriteCollapsed(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write profile: " << filename << std::endl;
+        return false;
+    }
+    // ';' separates the frames and the last space starts the count, so neither can appear in the name frame
+    std::string frame = name;
+    std::replace_if(frame.begin(), frame.end(), [](char c) { return c == ';' || std::isspace(static_cast<unsigned char>(c)); }, '_');
+    char address[8];
+    for (uint16_t hot : HotAddresses(addressCounts)) {
+        std::snprintf(address, sizeof(address), "0x%03X", hot);
+        file << frame << ";" << HandlerName(addressHandlers[hot]) << ";" << address << " " << addressCounts[hot] << "\n";
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,154 @@
+#include "../include/Rewind.h"
+#include <algorithm>
+#include <cstring>
+
+Rewind::Rewind(size_t bufferBytes, int keyframeInterval)
+    : keyframeInterval(std::max(keyframeInterval, 1)) {
+    // The frame records come out of the same budget: 1/8 of it. A record is 16 bytes and a frame averages ~100 bytes
+    // (tens of bytes of delta plus its share of a keyframe), so records and ring bytes run out at about the same time
+    size_t recordBytes = bufferBytes / 8;
+    entries.resize(std::max<size_t>(recordBytes / sizeof(Entry), 2));
+    // Room for at least a couple of worst-case frames (delta + keyframe, every byte changed)
+    ring.resize(std::max(bufferBytes - recordBytes, 4 * (Chip8::saveStateSize + 8)));
+    current.resize(Chip8::saveStateSize);
+    scratch.resize(Chip8::saveStateSize);
+    encoded.resize(2 * (Chip8::saveStateSize + 8));
+}
+
+void Rewind::Clear() {
+    first = 0;
+    count = 0;
+    head = 0;
+    sinceKeyframe = 0;
+}
+
+size_t Rewind::BytesUsed() const {
+    return count ? static_cast<size_t>(head - entries[first].start) : 0;
+}
+
+/*
+* Encoded runs: [uint16 skip][uint16 length][length bytes], little-endian. skip = unchanged bytes before the run.
+* A run only ends at 4+ unchanged bytes in a row (shorter gaps cost less to keep than a new 4-byte header),
+* so the output is never more than 4 bytes bigger than the state itself.
+*/
+size_t Rewind::EncodeRuns(const uint8_t* a, const uint8_t* b, uint8_t* out) {
+    constexpr size_t size = Chip8::saveStateSize;
+    auto diff = [a, b](size_t i) -> uint8_t { return b ? a[i] ^ b[i] : a[i]; };
+    uint8_t* start = out;
+    size_t i = 0;
+    size_t last = 0;  // End of the previous run
+    while (i < size) {
+        if (diff(i) == 0) {
+            ++i;
+            continue;
+        }
+        size_t end = i + 1;
+        size_t zeros = 0;
+        while (end < size && zeros < 4) {
+            zeros = diff(end) ? 0 : zeros + 1;
+            ++end;
+        }
+        end -= zeros;
+        size_t skip = i - last;
+        size_t length = end - i;
+        out[0] = static_cast<uint8_t>(skip);
+        out[1] = static_cast<uint8_t>(skip >> 8);
+        out[2] = static_cast<uint8_t>(length);
+        out[3] = static_cast<uint8_t>(length >> 8);
+        out += 4;
+        for (size_t j = i; j < end; ++j) {
+            *out++ = diff(j);
+        }
+        last = end;
+        i = end;
+    }
+    return out - start;
+}
+
+void Rewind::ApplyRuns(const uint8_t* runs, size_t size, uint8_t* state) {
+    const uint8_t* end = runs + size;
+    while (runs < end) {
+        size_t skip = runs[0] | (runs[1] << 8);
+        size_t length = runs[2] | (runs[3] << 8);
+        runs += 4;
+        state += skip;
+        for (size_t j = 0; j < length; ++j) {
+            *state++ ^= *runs++;
+        }
+    }
+}
+
+void Rewind::Push(const Chip8& chip) {
+    chip.SaveState(scratch);
+    bool keyframe = count == 0 || ++sinceKeyframe >= keyframeInterval;
+    // The first frame has nothing to diff against: its "delta" is the whole state
+    size_t deltaSize = EncodeRuns(scratch.data(), count ? current.data() : nullptr, encoded.data());
+    size_t keySize = keyframe ? EncodeRuns(scratch.data(), nullptr, encoded.data() + deltaSize) : 0;
+    if (keyframe) {
+        sinceKeyframe = 0;
+    }
+    size_t size = deltaSize + keySize;
+
+    // Frames are never split across the end of the ring: skip to the start of the next lap instead
+    size_t offset = head % ring.size();
+    if (offset + size > ring.size()) {
+        head += ring.size() - offset;
+    }
+    // Drop the oldest frames until the new one fits (or the record ring is full)
+    while (count > 0 && (entries[first].start + ring.size() < head + size || count == entries.size())) {
+        first = (first + 1) % entries.size();
+        --count;
+    }
+
+    std::memcpy(ring.data() + head % ring.size(), encoded.data(), size);
+    Entry& entry = At(count++);
+    entry.start = head;
+    entry.deltaSize = static_cast<uint32_t>(deltaSize);
+    entry.keySize = static_cast<uint32_t>(keySize);
+    head += size;
+    current.swap(scratch);
+}
+
+bool Rewind::StepBack(Chip8& chip) {
+    return Seek(chip, 1) == 1;
+}
+
+int Rewind::Seek(Chip8& chip, int frames) {
+    if (count < 2 || frames <= 0) {
+        return 0;
+    }
+    size_t back = std::min<size_t>(frames, count - 1);
+    size_t target = count - 1 - back;
+
+    // Undoing `back` deltas from the newest frame vs decoding the nearest keyframe and redoing the deltas up to the target: pick the cheaper one
+    size_t key = target + 1;
+    for (size_t i = target + 1; i-- > 0 && target - i < back;) {
+        if (At(i).keySize) {
+            key = i;
+            break;
+        }
+    }
+    if (key <= target) {
+        const Entry& keyEntry = At(key);
+        std::fill(current.begin(), current.end(), 0);
+        ApplyRuns(Data(keyEntry.start) + keyEntry.deltaSize, keyEntry.keySize, current.data());
+        for (size_t i = key + 1; i <= target; ++i) {
+            ApplyRuns(Data(At(i).start), At(i).deltaSize, current.data());
+        }
+    }
+    else {
+        for (size_t i = count - 1; i > target; --i) {
+            ApplyRuns(Data(At(i).start), At(i).deltaSize, current.data());
+        }
+    }
+
+    // Forget everything after the target (new frames are pushed from there)
+    head = At(target + 1).start;
+    count = target + 1;
+    sinceKeyframe = 0;
+    for (size_t i = count; i-- > 0 && !At(i).keySize && sinceKeyframe < keyframeInterval;) {
+        ++sinceKeyframe;
+    }
+    chip.LoadState(current);
+    return static_cast<int>(back);
+}
@@ -0,0 +1,162 @@
+#include "../include/RomCache.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define CHIP8_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint64_t RomFile::HashBytes(const uint8_t* bytes, size_t count) {
+    uint64_t h = 0xcbf29ce484222325ull;  // FNV-1a, same as Chip8::DisplayHash
+    for (size_t i = 0; i < count; ++i) {
+        h = (h ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+std::shared_ptr<RomFile> RomFile::FromBytes(std::vector<uint8_t> bytes, std::string name) {
+    std::shared_ptr<RomFile> rom(new RomFile());
+    rom->owned = std::move(bytes);
+    rom->data = rom->owned.data();
+    rom->size = rom->owned.size();
+    rom->hash = HashBytes(rom->data, rom->size);
+    rom->name = std::move(name);
+    return rom;
+}
+
+void RomFile::Assign(std::span<const uint8_t> bytes) {
+    owned.assign(bytes.begin(), bytes.end());  // Keeps the capacity, so refilling with a ROM no bigger than the last one doesn't allocate
+    data = owned.data();
+    size = owned.size();
+    hash = HashBytes(data, size);
+}
+
+std::shared_ptr<const RomFile> RomFile::Open(const std::string& filename, const char** error) {
+    // Failures below are "can't open/read" unless the size check says otherwise
+    auto fail = [error](const char* why) -> std::shared_ptr<const RomFile> {
+        if (error) {
+            *error = why;
+        }
+        return nullptr;
+    };
+    std::shared_ptr<RomFile> rom(new RomFile());
+    rom->name = filename;
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return fail("Failed to open ROM");
+    }
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart > static_cast<LONGLONG>(maxSize)) {
+        CloseHandle(file);
+        return fail(fileSize.QuadPart > static_cast<LONGLONG>(maxSize) ? "ROM too large" : "Failed to open ROM");
+    }
+    if (fileSize.QuadPart > 0) {
+        // The view keeps the mapping object alive, both handles can be closed right away
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        if (!view) {
+            CloseHandle(file);
+            return fail("Failed to open ROM");
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(view);
+        rom->owned.assign(bytes, bytes + fileSize.QuadPart);
+        UnmapViewOfFile(view);
+    }
+    CloseHandle(file);
+#elif defined(CHIP8_HAVE_MMAP)
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return fail("Failed to open ROM");
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size > static_cast<off_t>(maxSize)) {
+        close(fd);
+        return fail(info.st_size > static_cast<off_t>(maxSize) ? "ROM too large" : "Failed to open ROM");
+    }
+    if (info.st_size > 0) {
+        size_t length = static_cast<size_t>(info.st_size);
+        void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            close(fd);
+            return fail("Failed to open ROM");
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(view);
+        rom->owned.assign(bytes, bytes + length);
+        munmap(view, length);
+    }
+    close(fd);
+#else
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return fail("Failed to open ROM");
+    }
+    // No size up front here: read one byte past the limit, that's enough to tell the file is too big
+    rom->owned.resize(maxSize + 1);
+    file.read(reinterpret_cast<char*>(rom->owned.data()), static_cast<std::streamsize>(rom->owned.size()));
+    rom->owned.resize(static_cast<size_t>(file.gcount()));
+    if (rom->owned.size() > maxSize) {
+        return fail("ROM too large");
+    }
+#endif
+    rom->data = rom->owned.data();
+    rom->size = rom->owned.size();
+    rom->hash = HashBytes(rom->data, rom->size);
+    return rom;
+}
+
+RomCache& RomCache::Shared() {
+    static RomCache cache;
+    return cache;
+}
+
+RomImage RomCache::Load(const std::string& filename) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = byName.find(filename);
+        if (found != byName.end()) {
+            return found->second;
+        }
+    }
+    // Read outside the lock so a slow disk doesn't hold up lookups of other ROMs
+    RomImage image = RomFile::Open(filename);
+    if (!image) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto sameName = byName.find(filename);
+    if (sameName != byName.end()) {
+        return sameName->second;  // Another thread got there first
+    }
+    auto sameContent = byHash.find(image->Hash());
+    if (sameContent != byHash.end() && std::ranges::equal(sameContent->second->Bytes(), image->Bytes())) {
+        image = sameContent->second;  // Same ROM under another path: share the first image, this copy is dropped
+    }
+    else {
+        byHash[image->Hash()] = image;
+    }
+    byName[filename] = image;
+    return image;
+}
+
+void RomCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    byName.clear();
+    byHash.clear();
+}
+
+size_t RomCache::Size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return byHash.size();
+}
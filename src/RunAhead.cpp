@@ -0,0 +1,51 @@
+#include "../include/RunAhead.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+RunAhead::RunAhead(int frames) : frames(frames) {
+    state.resize(Chip8::saveStateSize);
+}
+
+void RunAhead::Run(Chip8& chip) {
+    auto start = std::chrono::steady_clock::now();
+    if (frames > 0) {
+        // What the save state doesn't hold: frontend/stat bookkeeping that the speculative frames would otherwise change
+        uint64_t dirtyRows[32];
+        std::copy(std::begin(chip.dirtyRows), std::end(chip.dirtyRows), dirtyRows);
+        bool drawFlag = chip.drawFlag;
+        bool idle = chip.idle;
+        uint64_t keypadReads = chip.keypadReads;
+        uint64_t unknownOpcodes = chip.unknownOpcodes;
+        uint16_t lastUnknownOpcode = chip.lastUnknownOpcode;
+        uint64_t skippedInstructions = chip.skippedInstructions;
+        Chip8Profiler* profiler = chip.profiler;
+        chip.profiler = nullptr;  // Speculative instructions aren't part of the real run
+
+        chip.SaveState(state);
+        uint64_t target = chip.frameCount + frames;
+        while (chip.frameCount < target) {
+            chip.RunUntilFrame(chip.instructionsPerFrame);
+            chip.drawFlag = false;
+        }
+        std::copy(std::begin(chip.display), std::end(chip.display), display);
+        soundOn = chip.soundTimer > 0;
+        chip.LoadState(state);
+
+        std::copy(std::begin(dirtyRows), std::end(dirtyRows), chip.dirtyRows);
+        chip.drawFlag = drawFlag;
+        chip.idle = idle;
+        chip.keypadReads = keypadReads;
+        chip.unknownOpcodes = unknownOpcodes;
+        chip.lastUnknownOpcode = lastUnknownOpcode;
+        chip.skippedInstructions = skippedInstructions;
+        chip.profiler = profiler;
+    }
+    else {
+        std::copy(std::begin(chip.display), std::end(chip.display), display);
+        soundOn = chip.soundTimer > 0;
+    }
+    lastNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    totalNanoseconds += lastNanoseconds;
+    ++runs;
+}
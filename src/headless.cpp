@@ -0,0 +1,263 @@
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include "../include/Chip8.h"
+#include "../include/Movie.h"
+#include "../include/Profiler.h"
+#include "../include/RomCache.h"
+#include "../include/RunAhead.h"
+
+/*
+* Headless batch runner (no SDL): loads a ROM, runs it for a fixed number of frames or instructions
+* with a fixed RNG seed and scripted keypad input, then prints one JSON object with the results.
+*
+* Usage: chip8-headless <rom> [--frames N | --instructions N] [--seed S] [--ipf N] [--input script.txt] [--record out.movie] [--profile out] [--run-ahead N]
+*        chip8-headless <rom> --movie in.movie
+*
+* Input script: one event per line, "<frame> <key 0-F> <down|up>", applied at the start of that frame. '#' starts a comment.
+*   120 5 down
+*   130 5 up
+*
+* --record saves the run as a movie (seed, speed, key transitions, per-frame display hashes, see Movie.h).
+* --movie replays one and exits with 3 if any frame's display hash differs from the recording.
+* --profile writes out.json and out.folded (flame graph input) with per-handler/per-address counts, builds with CHIP8_PROFILE only.
+* --run-ahead runs N frames ahead after every frame like a frontend would (see RunAhead.h) and adds its cost to the output;
+*   the run itself (registers, hash, movie) is the same as without it.
+*/
+static void PrintUsage() {
+    std::cerr << "Usage: chip8-headless <rom> [--frames N | --instructions N] [--seed S] [--ipf N] [--input script.txt] [--record out.movie] [--profile out] [--run-ahead N]" << std::endl;
+    std::cerr << "       chip8-headless <rom> --movie in.movie" << std::endl;
+}
+
+struct KeyEvent {
+    uint64_t frame;
+    uint8_t key;
+    bool pressed;
+};
+
+static bool LoadInputScript(const std::string& path, std::vector<KeyEvent>& events) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open input script: " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        uint64_t frame;
+        std::string key, state;
+        if (!(fields >> frame)) {
+            continue;  // Empty or comment-only line
+        }
+        if (!(fields >> key >> state) || key.size() != 1 || !std::isxdigit(static_cast<unsigned char>(key[0])) || (state != "down" && state != "up")) {
+            std::cerr << "Bad input script line " << lineNumber << ": " << line << std::endl;
+            return false;
+        }
+        events.push_back({ frame, static_cast<uint8_t>(std::stoi(key, nullptr, 16)), state == "down" });
+    }
+    // Keep the script order for events on the same frame
+    std::stable_sort(events.begin(), events.end(), [](const KeyEvent& a, const KeyEvent& b) { return a.frame < b.frame; });
+    return true;
+}
+
+// --movie: replays a recorded movie and reports whether every frame matched
+static int ReplayMain(const std::string& rom, const std::string& moviePath) {
+    Movie movie;
+    if (!movie.Load(moviePath)) {
+        return 2;
+    }
+    const char* error = nullptr;
+    RomImage image = RomFile::Open(rom, &error);
+    if (!image) {
+        std::cerr << error << ": " << rom << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ReplayResult result = ReplayMovie(image->Bytes(), movie);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (!result.loaded) {
+        return 1;
+    }
+
+    char hash[32];
+    std::snprintf(hash, sizeof(hash), "0x%016llx", static_cast<unsigned long long>(result.displayHash));
+    std::cout << "{\"rom\": " << JsonString(rom)
+        << ", \"movie\": " << JsonString(moviePath)
+        << ", \"seed\": " << movie.seed
+        << ", \"frames\": " << result.frames
+        << ", \"instructions\": " << result.instructions
+        << ", \"seconds\": " << elapsed.count()
+        << ", \"hashes_checked\": " << result.hashesChecked
+        << ", \"mismatches\": " << result.mismatches;
+    if (result.mismatches > 0) {
+        std::cout << ", \"first_mismatch_frame\": " << result.firstMismatch;
+    }
+    std::cout << ", \"framebuffer_hash\": \"" << hash << "\"}" << std::endl;
+    return result.mismatches > 0 ? 3 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        PrintUsage();
+        return 2;
+    }
+    std::string rom = argv[1];
+    uint64_t frames = 600;        // 10 seconds of emulated time by default
+    uint64_t instructions = 0;    // 0 = run by frames
+    unsigned seed = 0;
+    int ipf = 11;
+    std::string inputPath;
+    std::string recordPath;
+    std::string moviePath;
+    std::string profilePath;
+    int runAheadFrames = 0;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 2;
+        }
+        std::string value = argv[++i];
+        // stoull/stoi throw on "abc" or out of range values: report them like any other bad argument
+        try {
+            if (arg == "--frames") frames = std::stoull(value);
+            else if (arg == "--instructions") instructions = std::stoull(value);
+            else if (arg == "--seed") seed = static_cast<unsigned>(std::stoul(value));
+            else if (arg == "--ipf") ipf = std::stoi(value);
+            else if (arg == "--input") inputPath = value;
+            else if (arg == "--record") recordPath = value;
+            else if (arg == "--movie") moviePath = value;
+            else if (arg == "--profile") profilePath = value;
+            else if (arg == "--run-ahead") runAheadFrames = std::stoi(value);
+            else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 2;
+            }
+        }
+        catch (const std::exception&) {
+            std::cerr << "Bad value for " << arg << ": " << value << std::endl;
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (ipf < 1) {
+        // No instruction would ever run: --instructions would loop forever and --frames would only tick the timers
+        std::cerr << "--ipf must be at least 1" << std::endl;
+        return 2;
+    }
+
+    if (!moviePath.empty()) {
+        return ReplayMain(rom, moviePath);
+    }
+
+    std::vector<KeyEvent> events;
+    if (!inputPath.empty() && !LoadInputScript(inputPath, events)) {
+        return 2;
+    }
+
+    Chip8 emulator(seed);  // Fixed seed instead of the clock so runs are repeatable
+    emulator.instructionsPerFrame = ipf;
+    if (!emulator.LoadROM(rom)) {
+        std::cerr << emulator.loadError << ": " << rom << std::endl;
+        return 1;
+    }
+    Chip8Profiler profiler(rom.substr(rom.find_last_of("/\\") + 1));
+    if (!profilePath.empty()) {
+        if (!Chip8Profiler::Enabled()) {
+            std::cerr << "--profile needs a build with CHIP8_PROFILE defined" << std::endl;
+            return 2;
+        }
+        emulator.profiler = &profiler;
+    }
+
+    MovieRecorder recorder(emulator);
+    size_t nextEvent = 0;
+    auto applyEvents = [&]() {
+        while (nextEvent < events.size() && events[nextEvent].frame <= emulator.frameCount) {
+            emulator.keypad[events[nextEvent].key] = events[nextEvent].pressed ? 1 : 0;
+            ++nextEvent;
+        }
+        recorder.Update(emulator);
+    };
+    RunAhead runAhead(runAheadFrames);
+    uint64_t lastFrame = emulator.frameCount;
+    auto frameDone = [&]() {
+        if (runAheadFrames > 0 && emulator.frameCount != lastFrame) {
+            lastFrame = emulator.frameCount;
+            runAhead.Run(emulator);
+        }
+    };
+
+    uint64_t executed = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (instructions > 0) {
+        while (executed < instructions) {
+            applyEvents();
+            // Stop at each frame boundary so input lands on the right frame
+            uint64_t untilFrameEnd = emulator.instructionsPerFrame - emulator.frameCycles;
+            uint64_t batch = std::min(instructions - executed, untilFrameEnd);
+            executed += emulator.RunCycles(static_cast<int>(batch));
+            emulator.drawFlag = false;
+            frameDone();
+        }
+    }
+    else {
+        while (emulator.frameCount < frames) {
+            applyEvents();
+            executed += emulator.RunUntilFrame(ipf);
+            emulator.drawFlag = false;
+            frameDone();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    recorder.Update(emulator);
+    if (!recordPath.empty() && !recorder.GetMovie().Save(recordPath)) {
+        return 1;
+    }
+    if (!profilePath.empty() && (!profiler.WriteJson(profilePath + ".json") || !profiler.WriteCollapsed(profilePath + ".folded"))) {
+        return 1;
+    }
+
+    char hash[32];
+    std::snprintf(hash, sizeof(hash), "0x%016llx", static_cast<unsigned long long>(emulator.DisplayHash()));
+    std::cout << "{\"rom\": " << JsonString(rom)
+        << ", \"seed\": " << seed
+        << ", \"frames\": " << emulator.frameCount
+        << ", \"instructions\": " << executed
+        << ", \"seconds\": " << elapsed.count()
+        << ", \"instructions_per_second\": " << static_cast<uint64_t>(elapsed.count() > 0 ? executed / elapsed.count() : 0)
+        << ", \"skipped_instructions\": " << emulator.skippedInstructions
+        << ", \"pc\": " << emulator.pc
+        << ", \"index\": " << emulator.index
+        << ", \"sp\": " << static_cast<int>(emulator.sp)
+        << ", \"delay_timer\": " << static_cast<int>(emulator.delayTimer)
+        << ", \"sound_timer\": " << static_cast<int>(emulator.soundTimer)
+        << ", \"unknown_opcodes\": " << emulator.unknownOpcodes
+        << ", \"registers\": [";
+    for (int i = 0; i < 16; ++i) {
+        std::cout << (i ? ", " : "") << static_cast<int>(emulator.registers[i]);
+    }
+    std::cout << "], \"framebuffer_hash\": \"" << hash << "\"";
+    if (runAheadFrames > 0) {
+        // Extra CPU relative to the time spent on the real frames
+        double aheadSeconds = runAhead.MeanMicroseconds() * runAhead.Runs() / 1e6;
+        double realSeconds = elapsed.count() - aheadSeconds;
+        std::cout << ", \"run_ahead\": " << runAheadFrames
+            << ", \"run_ahead_us_per_frame\": " << runAhead.MeanMicroseconds()
+            << ", \"run_ahead_cpu_percent\": " << (realSeconds > 0 ? 100.0 * aheadSeconds / realSeconds : 0);
+    }
+    std::cout << "}" << std::endl;
+    return 0;
+}
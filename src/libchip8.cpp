@@ -0,0 +1,147 @@
+#include "../include/libchip8.h"
+#include "../include/Chip8.h"
+#include <algorithm>
+#include <iterator>
+#include <new>
+
+// The handle is the Chip8 itself, the C side only ever sees the pointer
+struct chip8_t {
+    Chip8 chip;
+    explicit chip8_t(unsigned seed) : chip(seed) {}
+};
+
+int chip8_api_version(void) {
+    return CHIP8_API_VERSION;
+}
+
+chip8_t* chip8_create(unsigned seed) {
+    return new (std::nothrow) chip8_t(seed);
+}
+
+void chip8_destroy(chip8_t* chip) {
+    delete chip;
+}
+
+int chip8_load_rom(chip8_t* chip, const uint8_t* data, size_t size) {
+    // The ROM is copied into an image for chip8_reset, and nothing may throw through extern "C"
+    try {
+        return chip->chip.LoadROM(std::span<const uint8_t>(data, size)) ? 1 : 0;
+    }
+    catch (...) {
+        chip->chip.loadError = "Out of memory";
+        return 0;
+    }
+}
+
+int chip8_load_rom_file(chip8_t* chip, const char* path) {
+    // The path string and the ROM image are allocated, and nothing may throw through extern "C"
+    try {
+        return chip->chip.LoadROM(std::string(path)) ? 1 : 0;
+    }
+    catch (...) {
+        chip->chip.loadError = "Out of memory";
+        return 0;
+    }
+}
+
+const char* chip8_load_error(const chip8_t* chip) {
+    return chip->chip.loadError;
+}
+
+void chip8_reset(chip8_t* chip, unsigned seed) {
+    chip->chip.Reset(seed);
+}
+
+void chip8_set_instructions_per_frame(chip8_t* chip, int instructions) {
+    chip->chip.instructionsPerFrame = std::max(instructions, 1);
+}
+
+void chip8_step(chip8_t* chip) {
+    chip->chip.Cycle();
+}
+
+int chip8_run_cycles(chip8_t* chip, int cycles) {
+    return chip->chip.RunCycles(cycles);
+}
+
+int chip8_run_frame(chip8_t* chip) {
+    // RunUntilFrame returns early on draws, keep going until the timers have ticked
+    Chip8& c = chip->chip;
+    uint64_t frame = c.frameCount;
+    bool drew = false;
+    int executed = 0;
+    while (c.frameCount == frame) {
+        executed += c.RunUntilFrame(c.instructionsPerFrame);
+        drew = drew || c.drawFlag;
+        c.drawFlag = false;
+    }
+    c.drawFlag = drew;  // Still reported by chip8_draw_flag
+    return executed;
+}
+
+void chip8_tick_timers(chip8_t* chip) {
+    chip->chip.TickTimers();
+}
+
+void chip8_set_key(chip8_t* chip, int key, int pressed) {
+    chip->chip.keypad[key & 0xF] = pressed ? 1 : 0;
+}
+
+void chip8_set_keys(chip8_t* chip, uint16_t pressed) {
+    for (int key = 0; key < 16; ++key) {
+        chip->chip.keypad[key] = (pressed >> key) & 1;
+    }
+}
+
+const uint64_t* chip8_display(const chip8_t* chip) {
+    return chip->chip.display;
+}
+
+void chip8_render_rgba(const chip8_t* chip, uint32_t* pixels) {
+    chip->chip.RenderRGBA(pixels);
+}
+
+uint64_t chip8_display_hash(const chip8_t* chip) {
+    return chip->chip.DisplayHash();
+}
+
+int chip8_draw_flag(chip8_t* chip) {
+    int drew = chip->chip.drawFlag ? 1 : 0;
+    chip->chip.drawFlag = false;
+    return drew;
+}
+
+int chip8_sound_on(const chip8_t* chip) {
+    return chip->chip.soundTimer > 0 ? 1 : 0;
+}
+
+void chip8_get_cpu_state(const chip8_t* chip, chip8_cpu_state* state) {
+    const Chip8& c = chip->chip;
+    std::copy(std::begin(c.registers), std::end(c.registers), state->v);
+    state->index = c.index;
+    state->pc = c.pc;
+    std::copy(std::begin(c.stack), std::end(c.stack), state->stack);
+    state->sp = c.sp;
+    state->delay_timer = c.delayTimer;
+    state->sound_timer = c.soundTimer;
+    state->waiting_for_key = c.waitingForKey ? 1 : 0;
+    state->opcode = c.opcode;
+    state->frame_count = c.frameCount;
+    state->unknown_opcodes = c.unknownOpcodes;
+}
+
+const uint8_t* chip8_memory(const chip8_t* chip) {
+    return chip->chip.memory;
+}
+
+size_t chip8_snapshot_size(void) {
+    return Chip8::saveStateSize;
+}
+
+size_t chip8_save_state(const chip8_t* chip, uint8_t* buffer, size_t size) {
+    return chip->chip.SaveState(std::span<uint8_t>(buffer, size));
+}
+
+int chip8_load_state(chip8_t* chip, const uint8_t* data, size_t size) {
+    return chip->chip.LoadState(std::span<const uint8_t>(data, size)) ? 1 : 0;
+}
@@ -42,7 +42,7 @@ int main() {
             << static_cast<int>(emulator.memory[0x201]) << std::endl;
     }
     else {
-        std::cout << "Failed to load ROM." << std::endl;
+        std::cout << "Failed to load ROM: " << emulator.loadError << std::endl;
     }
 
     // New: Test keypad
@@ -50,21 +50,23 @@ int main() {
     std::cout << "Keypad[1] pressed: " << static_cast<int>(emulator.keypad[1]) << std::endl;
 
     // Test display
-    emulator.gfx[0] = 0xFFFFFFFF;  // Set top-left pixel 'on'
-    emulator.gfx[64 * 31 + 63] = 0xFFFFFFFF;  // Bottom-right
-    std::cout << "GFX[0]: 0x" << std::hex << emulator.gfx[0] << std::endl;
-    std::cout << "GFX[last]: 0x" << std::hex << emulator.gfx[64 * 31 + 63] << std::endl;
+    emulator.display[0] |= 1ull << 63;  // Set top-left pixel 'on' (bit 63 of row 0)
+    emulator.display[31] |= 1ull;       // Bottom-right (bit 0 of row 31)
+    uint32_t pixels[64 * 32];
+    emulator.RenderRGBA(pixels);
+    std::cout << "GFX[0]: 0x" << std::hex << pixels[0] << std::endl;
+    std::cout << "GFX[last]: 0x" << std::hex << pixels[64 * 31 + 63] << std::endl;
 
     emulator.drawFlag = true;
     std::cout << "Draw flag: " << emulator.drawFlag << std::endl;
 
     // Test RNG
     /*for (int i = 0; i < 5; ++i) {
-        uint8_t randVal = static_cast<uint8_t>(emulator.randByte(emulator.randGen));
+        uint8_t randVal = emulator.randGen.NextByte();
         std::cout << "Random byte " << i << ": 0x" << std::hex << static_cast<int>(randVal) << std::endl;
     }*/
     for (int i = 0; i < 5; ++i) {
-        uint8_t randVal = static_cast<uint8_t>(emulator.randByte(emulator.randGen));
+        uint8_t randVal = emulator.randGen.NextByte();
         std::cout << "Random byte " << i << ": " << std::dec << static_cast<int>(randVal)
             << " (decimal) / 0x" << std::hex << static_cast<int>(randVal) << " (hex)" << std::endl;
     }
@@ -85,6 +87,7 @@ int main() {
     emulator.memory[0x200] = 0x00; emulator.memory[0x201] = 0xE0;  // 00E0
     // 0x00 is the high byte (first byte) of the 2-byte opcode.
     // 0xE0 is the low byte (second byte).
+    emulator.NotifyMemoryWrite(0x200, 2);  // We wrote program memory directly, tell the code caches
     emulator.Cycle();
     std::cout << "After clear: drawFlag = " << emulator.drawFlag << " (should be 1)" << std::endl;
 
@@ -93,10 +96,20 @@ int main() {
     // Test jump
     emulator.pc = 0x200;
     emulator.memory[0x200] = 0x12; emulator.memory[0x201] = 0x34;  // 1234 jump to 0x234
+    emulator.NotifyMemoryWrite(0x200, 2);
 	// jump format: 1nnn (1 from 1234)
     // target address: 0x234
     emulator.Cycle();
     std::cout << "After jump: PC = 0x" << std::hex << emulator.pc << " (should be 234)" << std::endl;
 
+    // Test batched run: one frame of IBMTest at 11 instructions per frame
+    if (emulator.LoadROM("IBMTest.ch8")) {
+        emulator.pc = 0x200;
+        emulator.drawFlag = false;
+        int executed = emulator.RunUntilFrame(11);
+        std::cout << "RunUntilFrame executed " << std::dec << executed << " instructions, drawFlag = " << emulator.drawFlag
+            << " PC: 0x" << std::hex << emulator.pc << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
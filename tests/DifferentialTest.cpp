@@ -0,0 +1,685 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Chip8.h"
+#include "../include/Chip8Jit.h"
+#include "../include/Chip8Lanes.h"
+#include "../include/DisplayExpand.h"
+#include "../include/Farm.h"
+#include "../include/Rewind.h"
+#include "../include/TripleBuffer.h"
+#ifdef CHIP8_TEST_AOT
+#include "../include/Chip8Aot.h"
+#endif
+
+/*
+* chip8-tests: the fast paths checked against the reference interpreter (Chip8::Cycle()).
+*
+* Usage: chip8-tests <check>                 Runs one check (CTest runs each as its own test), exit code 0 = passed
+*        chip8-tests rom <seed> <out.ch8>     Writes a random ROM (what the build compiles with chip8-aot for the "aot" check)
+*
+* The differential checks run the same ROM on a plain Chip8 with Cycle() and on the path under test, with the same seed and keypad,
+* and compare the whole machine (save state + the counters the save state doesn't hold) after every batch.
+* The ROMs are random bytes from a fixed seed, plus hand-written ones for cases random bytes rarely reach.
+* "dispatch" does the same for the other ways Chip8 itself runs code (CycleSwitch, RunThreaded, RunCycles, RunUntilFrame),
+* "farm" compares the results of jobs run on a multi-threaded Farm with the same jobs run one by one.
+* "expand" compares the SIMD display kernels with the scalar one, "rewind" checks that Rewind gives back exactly the states it was given,
+* "triple" that a TripleBuffer only ever hands over whole frames, newest last, "reset" compares Reset()/LoadROM on a used machine with a new one.
+* "aot" is only in chip8-aot-tests: the same file built with CHIP8_TEST_AOT and linked with the code chip8-aot generated from a random ROM
+* (an AOT program is one ROM per binary, see CMakeLists.txt).
+*/
+
+static int failures = 0;
+
+static void Fail(const std::string& check, const std::string& what) {
+    std::cerr << check << ": " << what << std::endl;
+    ++failures;
+}
+
+// Random ROM: mostly random bytes, with some 6XNN/AXXX/FX55/FX33 mixed in so registers get set and memory gets written
+static std::vector<uint8_t> RandomRom(Pcg32& rng, size_t size) {
+    std::vector<uint8_t> rom(size);
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        uint8_t high = rng.NextByte();
+        uint8_t low = rng.NextByte();
+        switch (rng.Next() % 8) {
+        case 0: high = 0x60 | (high & 0x0F); break;                 // 6XNN
+        case 1: high = 0xA0 | (high & 0x0F); break;                 // ANNN (I anywhere, FX1E can push it past 0xFFF)
+        case 2: high = 0xF0 | (high & 0x0F); low = (low & 1) ? 0x55 : 0x1E; break;   // FX55 / FX1E
+        case 3: high = 0xF0 | (high & 0x0F); low = 0x33; break;     // FX33
+        default: break;
+        }
+        rom[i] = high;
+        rom[i + 1] = low;
+    }
+    return rom;
+}
+
+// Random program: only valid opcodes, jumps and calls land on instructions inside the ROM and I mostly points into it.
+// Random bytes end the static walk after a few instructions; this is what chip8-aot compiles for the "aot" check,
+// so most of it becomes blocks, and FX33/FX55 keep overwriting them.
+static std::vector<uint8_t> RandomProgram(Pcg32& rng, size_t size) {
+    static const uint16_t fixed[] = { 0x00E0, 0x8000, 0x8001, 0x8002, 0x8003, 0x8004, 0x8005, 0x8006, 0x8007, 0x800E, 0x5000, 0x9000,
+                                      0xE09E, 0xE0A1, 0xF007, 0xF00A, 0xF015, 0xF018, 0xF01E, 0xF029, 0xF033, 0xF055, 0xF065 };
+    std::vector<uint8_t> rom(size);
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        uint16_t x = rng.Next() % 16;
+        uint16_t y = rng.Next() % 16;
+        uint16_t nn = rng.NextByte();
+        uint16_t target = static_cast<uint16_t>(0x200 + (rng.Next() % (size / 2)) * 2);
+        uint16_t opcode;
+        switch (rng.Next() % 32) {
+        case 0: opcode = 0x1000 | target; break;
+        case 1: case 2: opcode = 0x2000 | target; break;   // Calls go on at both ends, so the walk reaches most of the ROM
+        case 3: opcode = rng.Next() % 2 ? 0x00EE : 0xB000 | (target - 0x100); break;   // Both end the walk, so rarer than calls
+        case 4: opcode = 0xA000 | (rng.Next() % 8 ? target : 0xF00 | nn); break;  // ANNN, into the code or near the end of memory
+        case 5: case 6: opcode = (rng.Next() % 2 ? 0x3000 : 0x4000) | (x << 8) | nn; break;
+        case 7: case 8: case 9: case 10: opcode = 0x6000 | (x << 8) | nn; break;
+        case 11: case 12: opcode = 0x7000 | (x << 8) | nn; break;
+        case 13: opcode = 0xC000 | (x << 8) | nn; break;
+        case 14: opcode = 0xD000 | (x << 8) | (y << 4) | (nn & 0xF); break;
+        default:
+            opcode = fixed[rng.Next() % std::size(fixed)];
+            if (opcode != 0x00E0) {
+                opcode |= x << 8;
+            }
+            if ((opcode >> 12) == 0x5 || (opcode >> 12) == 0x8 || (opcode >> 12) == 0x9) {
+                opcode |= y << 4;
+            }
+            break;
+        }
+        if (i + 2 >= size) {
+            opcode = 0x1200;    // Running off the end goes back to the start
+        }
+        rom[i] = static_cast<uint8_t>(opcode >> 8);
+        rom[i + 1] = static_cast<uint8_t>(opcode);
+    }
+    return rom;
+}
+
+// Same machine? Compares everything SaveState writes, plus the counters it leaves out
+static bool Same(const Chip8& a, const Chip8& b, std::string& what) {
+    std::vector<uint8_t> stateA(Chip8::saveStateSize), stateB(Chip8::saveStateSize);
+    a.SaveState(stateA);
+    b.SaveState(stateB);
+    if (stateA != stateB) {
+        for (size_t i = 0; i < stateA.size(); ++i) {
+            if (stateA[i] != stateB[i]) {
+                what = "save state differs at byte " + std::to_string(i) + " (pc " + std::to_string(a.pc) + " vs " + std::to_string(b.pc) + ")";
+                break;
+            }
+        }
+        return false;
+    }
+    if (a.unknownOpcodes != b.unknownOpcodes || a.lastUnknownOpcode != b.lastUnknownOpcode || a.keypadReads != b.keypadReads) {
+        what = "unknownOpcodes/lastUnknownOpcode/keypadReads differ";
+        return false;
+    }
+    return true;
+}
+
+// Waits on the delay timer (FX07/3X00/1NNN loop), then for a key (FX0A), draws, and after 10 keys ends in a jump to itself:
+// the idle loops and waits RunUntilFrame fast-forwards, which random ROMs rarely build
+static const uint8_t idleRom[] = {
+    0x60, 0x1E,     // 0x200: V0 = 30
+    0xF0, 0x15,     // 0x202: delay = V0
+    0xF1, 0x07,     // 0x204: V1 = delay
+    0x31, 0x00,     // 0x206: skip if V1 == 0
+    0x12, 0x04,     // 0x208: jump 0x204
+    0xF2, 0x0A,     // 0x20A: V2 = key (waits)
+    0x70, 0x01,     // 0x20C: V0 += 1
+    0xA0, 0x50,     // 0x20E: I = font "0"
+    0xD0, 0x25,     // 0x210: draw
+    0x30, 0x28,     // 0x212: skip if V0 == 40
+    0x12, 0x02,     // 0x214: jump 0x202
+    0x12, 0x16,     // 0x216: jump 0x216
+};
+
+// CycleSwitch(), RunThreaded(), RunCycles() and RunUntilFrame() against Cycle() on one ROM, each with its own reference machine
+static void CheckDispatchRom(const std::string& name, std::span<const uint8_t> rom, Pcg32& rng, int instructions) {
+    const int perFrame = 1 + static_cast<int>(rng.Next() % 40);
+    Chip8 reference(9), switched(9), threaded(9);
+    reference.LoadROM(rom);
+    switched.LoadROM(rom);
+    threaded.LoadROM(rom);
+    std::string what;
+    for (int done = 0; done < instructions;) {
+        int batch = 1 + static_cast<int>(rng.Next() % 32);
+        uint8_t key = rng.NextByte() & 0x0F;
+        for (Chip8* chip : { &reference, &switched, &threaded }) {
+            chip->keypad[key] ^= 1;
+        }
+        for (int i = 0; i < batch; ++i) {
+            reference.Cycle();
+            switched.CycleSwitch();
+        }
+        threaded.RunThreaded(batch);
+        done += batch;
+        if (!Same(reference, switched, what) || !Same(reference, threaded, what)) {
+            Fail("dispatch", name + ": CycleSwitch/RunThreaded after " + std::to_string(done) + " instructions: " + what);
+            return;
+        }
+    }
+
+    // RunCycles: ticks the timers every perFrame instructions and stops after a draw or on FX0A
+    Chip8 cycleReference(9), cycles(9);
+    cycleReference.LoadROM(rom);
+    cycles.LoadROM(rom);
+    cycleReference.instructionsPerFrame = perFrame;
+    cycles.instructionsPerFrame = perFrame;
+    for (int done = 0; done < instructions;) {
+        int batch = 1 + static_cast<int>(rng.Next() % 64);
+        uint8_t key = rng.NextByte() & 0x0F;
+        cycleReference.keypad[key] ^= 1;
+        cycles.keypad[key] ^= 1;
+        int expected = 0;
+        while (expected < batch) {
+            cycleReference.Cycle();
+            ++expected;
+            if (++cycleReference.frameCycles >= perFrame) {
+                cycleReference.frameCycles = 0;
+                cycleReference.TickTimers();
+            }
+            if (cycleReference.drawFlag || cycleReference.waitingForKey) {
+                break;
+            }
+        }
+        int executed = cycles.RunCycles(batch);
+        cycleReference.drawFlag = false;
+        cycles.drawFlag = false;
+        done += executed;
+        if (executed != expected || !Same(cycleReference, cycles, what)) {
+            Fail("dispatch", name + ": RunCycles after " + std::to_string(done) + " instructions: " +
+                (executed != expected ? "ran " + std::to_string(executed) + " instructions, expected " + std::to_string(expected) : what));
+            return;
+        }
+    }
+
+    // RunUntilFrame: whatever it fast-forwards (idle loops, the rest of a frame spent waiting on FX0A) must end where running it would,
+    // keypadReads included
+    Chip8 frameReference(9), frames(9);
+    frameReference.LoadROM(rom);
+    frames.LoadROM(rom);
+    for (int done = 0; done < instructions;) {
+        // Mostly no key held, so FX0A really waits (toggling keys at random soon leaves some key down for good)
+        uint8_t key = rng.NextByte() & 0x0F;
+        bool press = rng.Next() % 4 == 0;
+        for (Chip8* chip : { &frameReference, &frames }) {
+            std::memset(chip->keypad, 0, sizeof(chip->keypad));
+            chip->keypad[key] = press ? 1 : 0;
+        }
+        int expected = 0;
+        while (frameReference.frameCycles < perFrame) {
+            frameReference.Cycle();
+            ++expected;
+            ++frameReference.frameCycles;
+            if (frameReference.drawFlag) {
+                break;
+            }
+        }
+        if (frameReference.frameCycles >= perFrame) {
+            frameReference.frameCycles = 0;
+            frameReference.TickTimers();
+        }
+        uint64_t skipped = frames.skippedInstructions;
+        int executed = frames.RunUntilFrame(perFrame);
+        executed += static_cast<int>(frames.skippedInstructions - skipped);
+        frameReference.drawFlag = false;
+        frames.drawFlag = false;
+        done += expected;
+        if (executed != expected || !Same(frameReference, frames, what)) {
+            Fail("dispatch", name + ": RunUntilFrame after " + std::to_string(done) + " instructions: " +
+                (executed != expected ? "ran + skipped " + std::to_string(executed) + " instructions, expected " + std::to_string(expected) : what));
+            return;
+        }
+    }
+}
+
+static void CheckDispatch() {
+    Pcg32 rng;
+    rng.Seed(7);
+    CheckDispatchRom("idle loops", idleRom, rng, 20000);
+    for (int i = 0; i < 200; ++i) {
+        std::vector<uint8_t> rom = RandomRom(rng, 64 + rng.Next() % 448);
+        CheckDispatchRom("random ROM " + std::to_string(i), rom, rng, 2000);
+    }
+}
+
+// Jobs of different lengths on a 4-thread farm (so they get stolen between workers halfway through), each result against
+// the same job run frame by frame with Cycle() on one thread. Some jobs share a ROM image, one ROM doesn't fit in memory,
+// and a few jobs ask for 0 frames.
+static void CheckFarm() {
+    Pcg32 rng;
+    rng.Seed(8);
+    std::vector<RomImage> images;
+    for (int i = 0; i < 8; ++i) {
+        images.push_back(RomFile::FromBytes(RandomRom(rng, 64 + rng.Next() % 448)));
+    }
+    images.push_back(RomFile::FromBytes(std::vector<uint8_t>(std::begin(idleRom), std::end(idleRom))));  // Waits for keys, so the input scripts matter
+    images.push_back(images.back());
+    images.push_back(RomFile::FromBytes(std::vector<uint8_t>(4096 - 0x200 + 1, 0x12)));
+
+    Farm farm(4);
+    std::vector<FarmJob> jobs;
+    for (int i = 0; i < 64; ++i) {
+        FarmJob job;
+        job.rom = images[rng.Next() % images.size()];
+        job.seed = rng.Next();
+        job.frames = i % 16 == 0 ? 0 : 1 + rng.Next() % 300;
+        job.instructionsPerFrame = 1 + static_cast<int>(rng.Next() % 40);
+        for (uint64_t frame = 0; frame < job.frames; frame += 1 + rng.Next() % 20) {
+            job.input.push_back({ frame, static_cast<uint8_t>(rng.Next() % 16), rng.Next() % 2 == 0 });
+        }
+        jobs.push_back(job);
+        farm.Add(std::move(job));
+    }
+    farm.Run();
+
+    for (size_t id = 0; id < jobs.size(); ++id) {
+        const FarmJob& job = jobs[id];
+        const FarmResult& result = farm.Results()[id];
+        Chip8 reference(job.seed);
+        bool loaded = reference.LoadROM(job.rom->Bytes());
+        if (result.loaded != loaded) {
+            Fail("farm", "job " + std::to_string(id) + ": loaded = " + std::to_string(result.loaded) + ", expected " + std::to_string(loaded));
+            return;
+        }
+        if (!loaded) {
+            continue;
+        }
+        size_t nextInput = 0;
+        while (reference.frameCount < job.frames) {
+            while (nextInput < job.input.size() && job.input[nextInput].frame <= reference.frameCount) {
+                reference.keypad[job.input[nextInput].key] = job.input[nextInput].pressed ? 1 : 0;
+                ++nextInput;
+            }
+            for (int i = 0; i < job.instructionsPerFrame; ++i) {
+                reference.Cycle();
+            }
+            reference.TickTimers();
+        }
+        bool same = result.frames == reference.frameCount && result.pc == reference.pc && result.index == reference.index &&
+            std::equal(std::begin(result.registers), std::end(result.registers), reference.registers) &&
+            result.displayHash == reference.DisplayHash();
+        if (!same) {
+            Fail("farm", "job " + std::to_string(id) + ": result differs from running it on its own");
+            return;
+        }
+    }
+}
+
+// Calls the ROM at 0x220 (V5 = 1), then with I = 0x1220 stores "65 07" over it with FX55 and calls it again (V5 = 7).
+// The store lands on memory[0x220] because addresses wrap at 0xFFF, so the compiled block at 0x220 has to be dropped.
+static const uint8_t wrappedStoreRom[] = {
+    0x22, 0x20,     // 0x200: call 0x220
+    0xAF, 0x20,     // 0x202: I = 0xF20
+    0x61, 0xC0,     // 0x204: V1 = 0xC0
+    0xF1, 0x1E,     // 0x206: I += V1
+    0xF1, 0x1E,     // 0x208: I += V1
+    0xF1, 0x1E,     // 0x20A: I += V1
+    0xF1, 0x1E,     // 0x20C: I += V1 (I = 0x1220)
+    0x60, 0x65,     // 0x20E: V0 = 0x65
+    0x61, 0x07,     // 0x210: V1 = 0x07
+    0xF1, 0x55,     // 0x212: memory[I & 0xFFF] = V0, V1 ("6507" at 0x220)
+    0x22, 0x20,     // 0x214: call 0x220
+    0x12, 0x16,     // 0x216: jump to itself
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0x65, 0x01,     // 0x220: V5 = 1
+    0x00, 0xEE,     // 0x222: return
+};
+
+// Runs `rom` with Cycle() and with Chip8Jit::Run in batches of 1-32 instructions, comparing after every batch
+static void CheckJitRom(const std::string& name, std::span<const uint8_t> rom, Pcg32& rng, int instructions) {
+    Chip8 reference(7);
+    Chip8 jitted(7);
+    reference.LoadROM(rom);
+    jitted.LoadROM(rom);
+    Chip8Jit jit(jitted);
+
+    int done = 0;
+    while (done < instructions) {
+        int batch = 1 + static_cast<int>(rng.Next() % 32);
+        uint8_t key = rng.NextByte() & 0x0F;
+        reference.keypad[key] ^= 1;
+        jitted.keypad[key] ^= 1;
+        for (int i = 0; i < batch; ++i) {
+            reference.Cycle();
+        }
+        jit.Run(batch);
+        done += batch;
+
+        std::string what;
+        if (!Same(reference, jitted, what)) {
+            Fail("jit", name + " after " + std::to_string(done) + " instructions: " + what);
+            return;
+        }
+    }
+}
+
+static void CheckJit() {
+    Pcg32 rng;
+    rng.Seed(1);
+    CheckJitRom("wrapped FX55", wrappedStoreRom, rng, 64);
+    for (int i = 0; i < 200; ++i) {
+        std::vector<uint8_t> rom = RandomRom(rng, 64 + rng.Next() % 448);
+        CheckJitRom("random ROM " + std::to_string(i), rom, rng, 2000);
+    }
+}
+
+// 8 lanes running random ROMs (lanes split into groups whenever they fetch different opcodes) against 8 Chip8s, timers ticking between batches
+static void CheckLanes() {
+    Pcg32 rng;
+    rng.Seed(3);
+    for (int round = 0; round < 25; ++round) {
+        Chip8Lanes<8> lanes;
+        Chip8 reference[8];
+        std::vector<uint8_t> shared = RandomRom(rng, 64 + rng.Next() % 448);
+        for (int l = 0; l < 8; ++l) {
+            reference[l].Reset(11 + l);
+            // The even lanes share one ROM (they run in the same group until their seeds/keys make them diverge)
+            reference[l].LoadROM(l % 2 == 0 ? shared : RandomRom(rng, 64 + rng.Next() % 448));
+            lanes.Load(l, reference[l]);
+        }
+        for (int batch = 0; batch < 100; ++batch) {
+            int count = 1 + static_cast<int>(rng.Next() % 32);
+            for (int l = 0; l < 8; ++l) {
+                uint8_t key = rng.NextByte() & 0x0F;
+                reference[l].keypad[key] ^= 1;
+                lanes.keypad[l][key] ^= 1;
+                for (int i = 0; i < count; ++i) {
+                    reference[l].Cycle();
+                }
+                reference[l].TickTimers();
+            }
+            lanes.Run(count);
+            lanes.TickTimers();
+
+            for (int l = 0; l < 8; ++l) {
+                Chip8 stored(11 + l);  // Lanes keep the RNG state, not the seed it came from
+                lanes.Store(l, stored);
+                std::string what;
+                if (!Same(reference[l], stored, what)) {
+                    Fail("lanes", "round " + std::to_string(round) + " lane " + std::to_string(l) + " batch " + std::to_string(batch) + ": " + what);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+// Every display expansion kernel the CPU has against the scalar one: random rows, scales that hit each kernel's special cases,
+// and a pitch wider than the image so writes past the end of a line would show up
+static void CheckExpand() {
+    Pcg32 rng;
+    rng.Seed(5);
+    const ExpandPath original = GetExpandPath();
+    const ExpandPath paths[] = { ExpandPath::SSE2, ExpandPath::AVX2 };
+    const int scales[] = { 1, 2, 3, 4, 5, 7, 8, 9, 12, 16 };
+    const uint32_t sentinel = 0xDEADBEEF;
+    for (int scale : scales) {
+        int pitch = 64 * scale + 3;
+        std::vector<uint32_t> expected(static_cast<size_t>(pitch) * 32 * scale, sentinel);
+        std::vector<uint32_t> actual(expected.size());
+        for (int round = 0; round < 20; ++round) {
+            uint64_t rows[32];
+            for (uint64_t& row : rows) {
+                row = static_cast<uint64_t>(rng.Next()) << 32 | rng.Next();
+            }
+            uint32_t on = rng.Next();
+            uint32_t off = rng.Next();
+            SetExpandPath(ExpandPath::Scalar);
+            ExpandDisplay(rows, expected.data(), pitch, on, off, scale);
+            for (ExpandPath path : paths) {
+                if (!SetExpandPath(path)) {
+                    continue;  // Not on this CPU/build
+                }
+                std::fill(actual.begin(), actual.end(), sentinel);
+                ExpandDisplay(rows, actual.data(), pitch, on, off, scale);
+                if (actual != expected) {
+                    Fail("expand", "path " + std::to_string(static_cast<int>(path)) + " differs from scalar at scale " + std::to_string(scale));
+                    SetExpandPath(original);
+                    return;
+                }
+            }
+        }
+    }
+    SetExpandPath(original);
+}
+
+// Rewind round trip: every frame pushed is kept as a full save state too, going back must give exactly that state.
+// The buffer is small so the ring wraps and old frames (and their keyframes) get dropped along the way.
+static void CheckRewind() {
+    Pcg32 rng;
+    rng.Seed(4);
+    for (int round = 0; round < 10; ++round) {
+        Chip8 chip(21 + round);
+        chip.LoadROM(RandomRom(rng, 64 + rng.Next() % 448));
+        Rewind rewind(64 << 10, 1 + rng.Next() % 60);
+        std::vector<std::vector<uint8_t>> history;
+        std::vector<uint8_t> state(Chip8::saveStateSize);
+
+        for (int frame = 0; frame < 2000; ++frame) {
+            chip.keypad[rng.NextByte() & 0x0F] ^= 1;
+            for (int i = 0; i < chip.instructionsPerFrame; ++i) {
+                chip.Cycle();
+            }
+            chip.TickTimers();
+            rewind.Push(chip);
+            chip.SaveState(state);
+            history.push_back(state);
+
+            if (rng.Next() % 40 != 0) {
+                continue;
+            }
+            // Seek() or StepBack(), either way it can't go further back than the oldest frame still held
+            bool step = rng.Next() % 2 == 0;
+            int wanted = step ? 1 : 1 + static_cast<int>(rng.Next() % 300);
+            size_t expected = std::min<size_t>(wanted, rewind.Frames() - 1);
+            int back = step ? (rewind.StepBack(chip) ? 1 : 0) : rewind.Seek(chip, wanted);
+            if (static_cast<size_t>(back) != expected) {
+                Fail("rewind", "round " + std::to_string(round) + " frame " + std::to_string(frame) + ": went back " + std::to_string(back) + " frames, expected " + std::to_string(expected));
+                return;
+            }
+            history.resize(history.size() - back);
+            chip.SaveState(state);
+            if (state != history.back()) {
+                Fail("rewind", "round " + std::to_string(round) + " frame " + std::to_string(frame) + ": state after going back " + std::to_string(back) + " frames differs");
+                return;
+            }
+        }
+    }
+}
+
+// TripleBuffer handoff: a producer thread publishes numbered frames as fast as it can while the consumer reads them.
+// Every frame the consumer gets must be whole (all rows from the same frame) and newer than the last one, and the last one published must arrive.
+static void CheckTripleBuffer() {
+    struct Frame {
+        uint64_t number = 0;
+        uint64_t rows[32] = {};
+    };
+    constexpr uint64_t frameCount = 200000;
+    TripleBuffer<Frame> buffer;
+    if (buffer.Update()) {
+        Fail("triple", "Update() returned a frame before anything was published");
+        return;
+    }
+
+    std::thread producer([&buffer] {
+        for (uint64_t number = 1; number <= frameCount; ++number) {
+            Frame& frame = buffer.Back();
+            frame.number = number;
+            for (int row = 0; row < 32; ++row) {
+                frame.rows[row] = number * 0x9E3779B97F4A7C15ull + row;
+                if (row == 16 && number % 64 == 0) {
+                    std::this_thread::yield();  // Lets the consumer in while a frame is half written, on a single core too
+                }
+            }
+            buffer.Publish();
+        }
+    });
+
+    uint64_t last = 0;
+    while (last < frameCount) {
+        if (!buffer.Update()) {
+            std::this_thread::yield();
+            continue;
+        }
+        const Frame& frame = buffer.Front();
+        if (frame.number <= last) {
+            Fail("triple", "got frame " + std::to_string(frame.number) + " after frame " + std::to_string(last));
+            break;
+        }
+        int torn = -1;
+        for (int row = 0; row < 32 && torn < 0; ++row) {
+            if (frame.rows[row] != frame.number * 0x9E3779B97F4A7C15ull + row) {
+                torn = row;
+            }
+        }
+        if (torn >= 0) {
+            Fail("triple", "frame " + std::to_string(frame.number) + " has row " + std::to_string(torn) + " from another frame");
+            break;
+        }
+        last = frame.number;
+    }
+    producer.join();
+    if (failures == 0 && buffer.Update()) {
+        Fail("triple", "Update() returned a frame again after the last one was read");
+    }
+}
+
+// Reset() after a run, and LoadROM over a used machine, must give the same machine as a new Chip8 + LoadROM
+static void CheckReset() {
+    Pcg32 rng;
+    rng.Seed(2);
+    Chip8 used(3);
+    std::vector<uint8_t> previous = RandomRom(rng, 3584);
+    used.LoadROM(previous);
+    for (int i = 0; i < 200; ++i) {
+        std::vector<uint8_t> rom = RandomRom(rng, 2 + rng.Next() % 1024);
+        Chip8 fresh(3);
+        fresh.LoadROM(rom);
+        std::string what;
+
+        // Runs the last ROM a while (stores all over memory), then loads this one over it
+        for (int n = 0; n < 3000; ++n) {
+            used.Cycle();
+        }
+        used.LoadROM(rom);
+        used.Reset(3);
+        if (!Same(fresh, used, what)) {
+            Fail("reset", "LoadROM over random ROM " + std::to_string(i) + ": " + what);
+            return;
+        }
+        for (int n = 0; n < 3000; ++n) {
+            used.Cycle();
+        }
+        used.Reset();
+        if (!Same(fresh, used, what)) {
+            Fail("reset", "Reset after random ROM " + std::to_string(i) + ": " + what);
+            return;
+        }
+    }
+}
+
+#ifdef CHIP8_TEST_AOT
+// The compiled ROM with Cycle() and with Chip8Aot::Run in batches of 1-64 instructions, comparing after every batch.
+// One ROM, but every round has its own CXNN seed and keypad input, so the runs go down different paths
+// (and FX55/FX33 rewrite different compiled blocks).
+// Odd rounds also attach a Chip8Jit to the same chip after the AOT engine and alternate between the two, so both have to
+// see every write (a JIT taking over the AOT engine's hook would leave stale blocks switched on).
+static void CheckAot() {
+    Pcg32 rng;
+    rng.Seed(5);
+    std::span<const uint8_t> rom(chip8AotProgram.rom, chip8AotProgram.romSize);
+    for (int round = 0; round < 100; ++round) {
+        Chip8 reference(31 + round);
+        Chip8 compiled(31 + round);
+        reference.LoadROM(rom);
+        compiled.LoadROM(rom);
+        Chip8Aot aot(compiled, chip8AotProgram);
+        if (aot.ActiveBlocks() != chip8AotProgram.blockCount) {
+            Fail("aot", "only " + std::to_string(aot.ActiveBlocks()) + " of " + std::to_string(chip8AotProgram.blockCount) + " blocks active after loading the ROM");
+            return;
+        }
+        std::unique_ptr<Chip8Jit> jit;
+        if (round % 2) {
+            jit = std::make_unique<Chip8Jit>(compiled);
+        }
+
+        int done = 0;
+        while (done < 5000) {
+            int batch = 1 + static_cast<int>(rng.Next() % 64);
+            uint8_t key = rng.NextByte() & 0x0F;
+            reference.keypad[key] ^= 1;
+            compiled.keypad[key] ^= 1;
+            for (int i = 0; i < batch; ++i) {
+                reference.Cycle();
+            }
+            bool useJit = jit && rng.Next() % 2;
+            if ((useJit ? jit->Run(batch) : aot.Run(batch)) != batch) {
+                Fail("aot", "round " + std::to_string(round) + ": Run(" + std::to_string(batch) + ") didn't run every instruction");
+                return;
+            }
+            reference.TickTimers();
+            compiled.TickTimers();
+            done += batch;
+
+            std::string what;
+            if (!Same(reference, compiled, what)) {
+                Fail("aot", "round " + std::to_string(round) + " after " + std::to_string(done) + " instructions: " + what);
+                return;
+            }
+        }
+    }
+}
+#endif
+
+// Writes RandomProgram(seed) for chip8-aot
+static int WriteRom(const std::string& seed, const std::string& path) {
+    Pcg32 rng;
+    rng.Seed(static_cast<uint32_t>(std::stoul(seed)));
+    std::vector<uint8_t> rom = RandomProgram(rng, 2048);
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(rom.data()), static_cast<std::streamsize>(rom.size()));
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 4 && std::string(argv[1]) == "rom") {
+        return WriteRom(argv[2], argv[3]);
+    }
+    if (argc != 2) {
+        std::cerr << "Usage: chip8-tests <dispatch|jit|farm|lanes|expand|rewind|triple|reset|aot> | rom <seed> <out.ch8>" << std::endl;
+        return 2;
+    }
+    std::string check = argv[1];
+    if (check == "dispatch") CheckDispatch();
+    else if (check == "jit") CheckJit();
+    else if (check == "farm") CheckFarm();
+    else if (check == "lanes") CheckLanes();
+    else if (check == "expand") CheckExpand();
+    else if (check == "rewind") CheckRewind();
+    else if (check == "triple") CheckTripleBuffer();
+    else if (check == "reset") CheckReset();
+#ifdef CHIP8_TEST_AOT
+    else if (check == "aot") CheckAot();
+#endif
+    else {
+        std::cerr << "Unknown check: " << check << std::endl;
+        return 2;
+    }
+    if (failures == 0) {
+        std::cout << check << ": passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
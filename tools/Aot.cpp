@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <cstdio>
+#include <cstdint>
+
+/*
+* chip8-aot: static recompiler from a CHIP-8 ROM to a C++ translation unit (see include/Chip8Aot.h for the runtime side).
+*
+* Usage: chip8-aot <rom> <out.cpp>
+*
+* The control flow is walked from 0x200: jumps, calls (and the return address after them), both sides of every skip and the
+* instruction after FX0A/FX33/FX55 become block starts ("leaders"). Each leader gets one function that runs straight-line code
+* up to the next control-flow instruction, the next leader or the end of the ROM, and leaves pc where the interpreter would.
+* BNNN targets depend on V0 at run time and aren't followed: the runtime falls back to Chip8::Cycle() wherever there's no block.
+*
+* Build the output into a native runner together with the core:
+*   chip8-aot pong.ch8 pong_aot.cpp
+*   g++ -O2 -std=c++20 -Iinclude pong_aot.cpp tools/AotMain.cpp src/Chip8Aot.cpp src/Chip8.cpp src/DisplayExpand.cpp src/Profiler.cpp src/RomCache.cpp -o pong
+*/
+
+namespace {
+
+constexpr int maxBlockInstructions = 256;
+
+struct Rom {
+    std::vector<uint8_t> bytes;
+    uint16_t End() const { return static_cast<uint16_t>(0x200 + bytes.size()); }
+    bool Has(uint16_t address) const { return address >= 0x200 && address + 1 < End(); }  // Whole opcode inside the ROM
+    uint16_t Opcode(uint16_t address) const { return (bytes[address - 0x200] << 8) | bytes[address + 1 - 0x200]; }
+};
+
+// Same decode as Chip8::HandlerFor: invalid encodings are left to Cycle() (it reports them)
+bool IsValid(uint16_t opcode) {
+    uint8_t nn = opcode & 0xFF;
+    switch (opcode >> 12) {
+    case 0x8: return (opcode & 0xF) <= 0x7 || (opcode & 0xF) == 0xE;
+    case 0xE: return nn == 0x9E || nn == 0xA1;
+    case 0xF: return nn == 0x07 || nn == 0x0A || nn == 0x15 || nn == 0x18 || nn == 0x1E || nn == 0x29 || nn == 0x33 || nn == 0x55 || nn == 0x65;
+    default: return true;
+    }
+}
+
+// Instructions that end a block: they set pc themselves (jumps, calls, returns, skips, FX0A) or may overwrite code (FX33, FX55)
+bool EndsBlock(uint16_t opcode) {
+    if (!IsValid(opcode)) {
+        return false;
+    }
+    switch (opcode >> 12) {
+    case 0x0: return opcode == 0x00EE;
+    case 0x1: case 0x2: case 0x3: case 0x4: case 0x5: case 0x9: case 0xB: case 0xE: return true;
+    case 0xF: return (opcode & 0xFF) == 0x0A || (opcode & 0xFF) == 0x33 || (opcode & 0xFF) == 0x55;
+    default: return false;
+    }
+}
+
+// Walks every reachable instruction, collecting the block starts
+std::set<uint16_t> FindLeaders(const Rom& rom, size_t& reachedCount) {
+    std::set<uint16_t> leaders = { 0x200 };
+    std::vector<bool> reached(4096, false);
+    std::vector<uint16_t> work = { 0x200 };
+    auto branch = [&](uint16_t target) {
+        leaders.insert(target);
+        work.push_back(target);
+    };
+    reachedCount = 0;
+    while (!work.empty()) {
+        uint16_t address = work.back();
+        work.pop_back();
+        // Follow straight-line code until something branches
+        while (rom.Has(address) && !reached[address]) {
+            reached[address] = true;
+            ++reachedCount;
+            uint16_t opcode = rom.Opcode(address);
+            uint16_t next = address + 2;
+            uint16_t nnn = opcode & 0x0FFF;
+            if (!IsValid(opcode)) {
+                address = next;
+                continue;
+            }
+            switch (opcode >> 12) {
+            case 0x0:
+                if (opcode == 0x00EE) {
+                    next = 0;  // Return addresses come from the calls
+                }
+                break;
+            case 0x1:
+                branch(nnn);
+                next = 0;
+                break;
+            case 0x2:
+                branch(nnn);
+                branch(address + 2);
+                next = 0;
+                break;
+            case 0x3: case 0x4: case 0x5: case 0x9: case 0xE:
+                branch(address + 2);
+                branch(address + 4);
+                next = 0;
+                break;
+            case 0xB:
+                next = 0;  // Target depends on V0
+                break;
+            case 0xF:
+                if (EndsBlock(opcode)) {
+                    branch(address + 2);
+                    next = 0;
+                }
+                break;
+            }
+            if (next == 0) {
+                break;
+            }
+            address = next;
+        }
+    }
+    return leaders;
+}
+
+std::string Hex(unsigned value, int digits) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "0x%0*X", digits, value);
+    return text;
+}
+
+// C++ for one instruction at `address`: the same state changes as its OP_* handler. Block-ending instructions set pc themselves
+void EmitInstruction(std::ostream& out, uint16_t address, uint16_t opcode) {
+    const std::string x = std::to_string((opcode >> 8) & 0xF);
+    const std::string y = std::to_string((opcode >> 4) & 0xF);
+    const std::string vx = "c.registers[" + x + "]";
+    const std::string vy = "c.registers[" + y + "]";
+    const std::string nn = Hex(opcode & 0xFF, 2);
+    const std::string nnn = Hex(opcode & 0x0FFF, 3);
+    const std::string next = Hex(address + 2, 3);
+    const std::string skip = Hex(address + 4, 3);
+    const std::string indent = "    ";
+    out << indent << "// " << Hex(address, 3) << ": " << Hex(opcode, 4) << "\n";
+
+    if (!IsValid(opcode)) {
+        out << indent << "c.pc = " << Hex(address, 3) << ";\n";
+        out << indent << "c.Cycle();\n";
+        return;
+    }
+    switch (opcode >> 12) {
+    case 0x0:
+        if (opcode == 0x00E0) out << indent << "chip8aot::Clear(c);\n";
+        else if (opcode == 0x00EE) out << indent << "if (c.sp > 0) { --c.sp; c.pc = c.stack[c.sp]; } else { c.pc = " << next << "; }\n";
+        break;  // Other 0NNN are ignored
+    case 0x1: out << indent << "c.pc = " << nnn << ";\n"; break;
+    case 0x2: out << indent << "if (c.sp < 16) { c.stack[c.sp++] = " << next << "; c.pc = " << nnn << "; } else { c.pc = " << next << "; }\n"; break;
+    case 0x3: out << indent << "c.pc = " << vx << " == " << nn << " ? " << skip << " : " << next << ";\n"; break;
+    case 0x4: out << indent << "c.pc = " << vx << " != " << nn << " ? " << skip << " : " << next << ";\n"; break;
+    case 0x5: out << indent << "c.pc = " << vx << " == " << vy << " ? " << skip << " : " << next << ";\n"; break;
+    case 0x6: out << indent << vx << " = " << nn << ";\n"; break;
+    case 0x7: out << indent << vx << " += " << nn << ";\n"; break;
+    case 0x8:
+        switch (opcode & 0xF) {
+        case 0x0: out << indent << vx << " = " << vy << ";\n"; break;
+        case 0x1: out << indent << vx << " |= " << vy << ";\n"; break;
+        case 0x2: out << indent << vx << " &= " << vy << ";\n"; break;
+        case 0x3: out << indent << vx << " ^= " << vy << ";\n"; break;
+        case 0x4: out << indent << "{ unsigned sum = " << vx << " + " << vy << "; " << vx << " = sum & 0xFF; c.registers[15] = sum > 0xFF; }\n"; break;
+        case 0x5: out << indent << "{ uint8_t flag = " << vx << " >= " << vy << "; " << vx << " -= " << vy << "; c.registers[15] = flag; }\n"; break;
+        case 0x6: out << indent << "{ uint8_t flag = " << vx << " & 1; " << vx << " >>= 1; c.registers[15] = flag; }\n"; break;
+        case 0x7: out << indent << "{ uint8_t flag = " << vy << " >= " << vx << "; " << vx << " = " << vy << " - " << vx << "; c.registers[15] = flag; }\n"; break;
+        case 0xE: out << indent << "{ uint8_t flag = " << vx << " >> 7; " << vx << " <<= 1; c.registers[15] = flag; }\n"; break;
+        }
+        break;
+    case 0x9: out << indent << "c.pc = " << vx << " != " << vy << " ? " << skip << " : " << next << ";\n"; break;
+    case 0xA: out << indent << "c.index = " << nnn << ";\n"; break;
+    case 0xB: out << indent << "c.pc = " << nnn << " + c.registers[0];\n"; break;
+    case 0xC: out << indent << vx << " = c.randGen.NextByte() & " << nn << ";\n"; break;
+    case 0xD: out << indent << "chip8aot::Draw(c, " << x << ", " << y << ", " << (opcode & 0xF) << ");\n"; break;
+    case 0xE:
+        out << indent << "++c.keypadReads;\n";
+        out << indent << "c.pc = " << ((opcode & 0xFF) == 0x9E ? "" : "!") << "c.keypad[" << vx << " & 0xF] ? " << skip << " : " << next << ";\n";
+        break;
+    case 0xF:
+        switch (opcode & 0xFF) {
+        case 0x07: out << indent << vx << " = c.delayTimer;\n"; break;
+        case 0x0A: out << indent << "if (chip8aot::WaitKey(c, " << x << ", " << Hex(address, 3) << ")) { c.pc = " << next << "; }\n"; break;
+        case 0x15: out << indent << "c.delayTimer = " << vx << ";\n"; break;
+        case 0x18: out << indent << "c.soundTimer = " << vx << ";\n"; break;
+        case 0x1E: out << indent << "c.index += " << vx << ";\n"; break;
+        case 0x29: out << indent << "c.index = 0x050 + (" << vx << " & 0xF) * 5;\n"; break;
+        case 0x33: out << indent << "chip8aot::StoreBcd(c, " << x << ");\n" << indent << "c.pc = " << next << ";\n"; break;
+        case 0x55: out << indent << "chip8aot::StoreRegisters(c, " << x << ");\n" << indent << "c.pc = " << next << ";\n"; break;
+        case 0x65: out << indent << "chip8aot::LoadRegisters(c, " << x << ");\n"; break;
+        }
+        break;
+    }
+}
+
+// C++ string literal for the ROM name: file names can contain quotes, backslashes or control characters
+// ('?' too, so "??=" can't become a trigraph on compilers that still have them)
+std::string CppString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\' || c == '?') {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20 || c == 0x7F) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\%03o", static_cast<unsigned char>(c));  // Octal: always exactly 3 digits, unlike \x
+            out += escaped;
+        }
+        else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// Same name for the "// Generated from" comment line: a newline would end the comment and the rest would be compiled
+std::string CommentText(std::string text) {
+    std::replace_if(text.begin(), text.end(), [](char c) { return static_cast<unsigned char>(c) < 0x20 || c == 0x7F; }, ' ');
+    return text;
+}
+
+struct BlockInfo {
+    uint16_t address;
+    uint16_t bytes;
+    uint16_t instructions;
+};
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: chip8-aot <rom> <out.cpp>" << std::endl;
+        return 2;
+    }
+    std::string romPath = argv[1];
+    std::ifstream file(romPath, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open ROM: " << romPath << std::endl;
+        return 1;
+    }
+    Rom rom;
+    rom.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (rom.bytes.empty() || rom.bytes.size() > 4096 - 0x200) {
+        std::cerr << "Bad ROM size: " << rom.bytes.size() << " bytes" << std::endl;
+        return 1;
+    }
+    std::string name = romPath.substr(romPath.find_last_of("/\\") + 1);
+
+    size_t reached = 0;
+    std::set<uint16_t> leaders = FindLeaders(rom, reached);
+
+    std::ostringstream code;
+    std::vector<BlockInfo> blocks;
+    for (uint16_t leader : leaders) {
+        if (!rom.Has(leader)) {
+            continue;  // Outside the ROM (jump into data past the end, or into the interpreter area): left to Cycle()
+        }
+        code << "void Block_" << Hex(leader, 3).substr(2) << "(Chip8& c) {\n";
+        uint16_t address = leader;
+        uint16_t lastOpcode = 0;
+        bool ended = false;
+        int count = 0;
+        while (!ended && count < maxBlockInstructions && rom.Has(address) && (address == leader || !leaders.count(address))) {
+            uint16_t opcode = rom.Opcode(address);
+            EmitInstruction(code, address, opcode);
+            ended = EndsBlock(opcode);
+            lastOpcode = opcode;
+            address += 2;
+            ++count;
+        }
+        if (!ended) {
+            code << "    c.pc = " << Hex(address, 3) << ";\n";
+        }
+        if (IsValid(lastOpcode)) {
+            code << "    c.opcode = " << Hex(lastOpcode, 4) << ";\n";  // Cycle() already stored it for invalid opcodes
+        }
+        code << "}\n\n";
+        blocks.push_back({ leader, static_cast<uint16_t>(address - leader), static_cast<uint16_t>(count) });
+    }
+
+    std::ofstream out(argv[2]);
+    if (!out) {
+        std::cerr << "Failed to write " << argv[2] << std::endl;
+        return 1;
+    }
+    out << "// Generated by chip8-aot from " << CommentText(name) << ", do not edit\n";
+    out << "#include <iterator>\n";
+    out << "#include \"Chip8Aot.h\"\n\n";
+    out << "namespace {\n\n";
+    out << "const uint8_t rom[] = {";
+    for (size_t i = 0; i < rom.bytes.size(); ++i) {
+        out << (i % 16 ? " " : "\n    ") << Hex(rom.bytes[i], 2) << ",";
+    }
+    out << "\n};\n\n";
+    out << code.str();
+    out << "const Chip8AotBlock blocks[] = {\n";
+    for (const BlockInfo& block : blocks) {
+        out << "    { " << Hex(block.address, 3) << ", " << block.bytes << ", " << block.instructions << ", &Block_" << Hex(block.address, 3).substr(2) << " },\n";
+    }
+    out << "};\n\n";
+    out << "}\n\n";
+    out << "extern const Chip8AotProgram chip8AotProgram = { " << CppString(name) << ", rom, sizeof(rom), blocks, std::size(blocks) };\n";
+    if (!out) {
+        std::cerr << "Failed to write " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << name << ": " << blocks.size() << " blocks, " << reached << " of " << rom.bytes.size() / 2 << " instruction slots reached" << std::endl;
+    return 0;
+}
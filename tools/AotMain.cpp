@@ -0,0 +1,103 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include "../include/Chip8.h"
+#include "../include/Chip8Aot.h"
+#include "../include/Profiler.h"
+
+/*
+* Runner for an ahead-of-time compiled ROM (link it with the file chip8-aot generated, see tools/Aot.cpp).
+* Runs the embedded ROM for a fixed number of frames and prints the same JSON fields as chip8-headless,
+* so a sweep can switch between the two and compare framebuffer hashes.
+*
+* Usage: <runner> [--frames N] [--seed S] [--ipf N] [--interpret]
+* --interpret runs the same loop with Chip8::Cycle() only (checking/timing the compiled code against the interpreter).
+*/
+static void PrintUsage() {
+    std::cerr << "Usage: <runner> [--frames N] [--seed S] [--ipf N] [--interpret]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t frames = 600;
+    unsigned seed = 0;
+    int ipf = 11;
+    bool interpret = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--interpret") {
+            interpret = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 2;
+        }
+        std::string value = argv[++i];
+        // stoull/stoi throw on "abc" or out of range values: report them like any other bad argument
+        try {
+            if (arg == "--frames") frames = std::stoull(value);
+            else if (arg == "--seed") seed = static_cast<unsigned>(std::stoul(value));
+            else if (arg == "--ipf") ipf = std::stoi(value);
+            else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 2;
+            }
+        }
+        catch (const std::exception&) {
+            std::cerr << "Bad value for " << arg << ": " << value << std::endl;
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (ipf < 1) {
+        // No instruction would ever run, --frames would only tick the timers
+        std::cerr << "--ipf must be at least 1" << std::endl;
+        return 2;
+    }
+
+    Chip8 emulator(seed);
+    emulator.instructionsPerFrame = ipf;
+    if (!emulator.LoadROM(std::span<const uint8_t>(chip8AotProgram.rom, chip8AotProgram.romSize))) {
+        return 1;
+    }
+    Chip8Aot aot(emulator, chip8AotProgram);
+
+    uint64_t executed = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (emulator.frameCount < frames) {
+        if (interpret) {
+            for (int i = 0; i < ipf; ++i) {
+                emulator.Cycle();
+            }
+            executed += ipf;
+        }
+        else {
+            executed += aot.Run(ipf);
+        }
+        emulator.TickTimers();
+        emulator.drawFlag = false;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    char hash[32];
+    std::snprintf(hash, sizeof(hash), "0x%016llx", static_cast<unsigned long long>(emulator.DisplayHash()));
+    std::cout << "{\"rom\": " << JsonString(chip8AotProgram.name)
+        << ", \"seed\": " << seed
+        << ", \"frames\": " << emulator.frameCount
+        << ", \"instructions\": " << executed
+        << ", \"seconds\": " << elapsed.count()
+        << ", \"instructions_per_second\": " << static_cast<uint64_t>(elapsed.count() > 0 ? executed / elapsed.count() : 0)
+        << ", \"pc\": " << emulator.pc
+        << ", \"index\": " << emulator.index
+        << ", \"sp\": " << static_cast<int>(emulator.sp)
+        << ", \"delay_timer\": " << static_cast<int>(emulator.delayTimer)
+        << ", \"sound_timer\": " << static_cast<int>(emulator.soundTimer)
+        << ", \"registers\": [";
+    for (int i = 0; i < 16; ++i) {
+        std::cout << (i ? ", " : "") << static_cast<int>(emulator.registers[i]);
+    }
+    std::cout << "], \"framebuffer_hash\": \"" << hash << "\", \"compiled_blocks\": " << aot.ActiveBlocks() << "}" << std::endl;
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "../include/Chip8Fuzz.h"
+
+/*
+* Fuzz target: every input is a ROM, run for Chip8Fuzz::defaultCycles instructions (see Chip8Fuzz.h).
+*
+* libFuzzer (cmake -DCHIP8_LIBFUZZER=ON, clang): this file is linked with -fsanitize=fuzzer and the edge map lives in the
+* __libfuzzer_extra_counters section, so libFuzzer sees the emulated program's (PC, handler) edges on top of its own
+* coverage of the C++ code. AFL++ builds the same entry point with afl-clang-fast++ -fsanitize=fuzzer.
+* Without libFuzzer it is linked with tools/FuzzMain.cpp, which calls it on files (crash reproduction, afl-fuzz ... @@)
+* and has a --bench mode for reset + execute throughput.
+*/
+#if defined(CHIP8_LIBFUZZER) && defined(__linux__)
+__attribute__((section("__libfuzzer_extra_counters"), used))
+#endif
+static uint8_t edgeMap[Chip8Fuzz::mapSize];
+
+Chip8Fuzz& Chip8FuzzTarget() {
+    static Chip8Fuzz fuzz(edgeMap);
+    return fuzz;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    Chip8FuzzTarget().Run(std::span<const uint8_t>(data, size));
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../include/Chip8Fuzz.h"
+#include "../include/Rng.h"
+
+/*
+* chip8-fuzz without libFuzzer: runs the fuzz target (tools/Fuzz.cpp) on files, or times it.
+*
+* Usage: chip8-fuzz file...                          Runs every file once (reproduce a crash, or afl-fuzz -i in -o out -- chip8-fuzz @@)
+*        chip8-fuzz --bench N [--cycles C] [--seed S] [file...]   N executions of generated inputs, prints executions/s and edges as JSON
+*
+* --bench inputs are random ROMs (2-512 bytes), or copies of the given files with a few bytes changed (like a fuzzer's mutations),
+* all generated before the timer starts so only Reset + LoadROM + the bounded run are measured. --cycles changes the bound
+* (default Chip8Fuzz::defaultCycles, the one the fuzz target uses).
+*/
+Chip8Fuzz& Chip8FuzzTarget();
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static std::vector<uint8_t> ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open: " << path << std::endl;
+        return {};
+    }
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t bench = 0;
+    unsigned seed = 1;
+    int cycles = Chip8Fuzz::defaultCycles;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bench" || arg == "--cycles" || arg == "--seed") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return 2;
+            }
+            std::string value = argv[++i];
+            if (arg == "--bench") bench = std::stoull(value);
+            else if (arg == "--cycles") cycles = std::stoi(value);
+            else seed = static_cast<unsigned>(std::stoul(value));
+        }
+        else {
+            files.push_back(arg);
+        }
+    }
+
+    if (bench == 0) {
+        for (const std::string& path : files) {
+            std::vector<uint8_t> input = ReadFile(path);
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+        }
+        std::cout << "{\"inputs\": " << files.size() << ", \"edges\": " << Chip8FuzzTarget().EdgesHit() << "}" << std::endl;
+        return 0;
+    }
+
+    std::vector<std::vector<uint8_t>> bases;
+    for (const std::string& path : files) {
+        bases.push_back(ReadFile(path));
+    }
+    Pcg32 rng;
+    rng.Seed(seed);
+    std::vector<std::vector<uint8_t>> inputs(4096);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (!bases.empty()) {
+            inputs[i] = bases[i % bases.size()];
+            for (int m = 0; m < 4 && !inputs[i].empty(); ++m) {
+                inputs[i][rng.Next() % inputs[i].size()] = rng.NextByte();
+            }
+        }
+        else {
+            inputs[i].resize(2 + rng.Next() % 511);
+            for (uint8_t& byte : inputs[i]) {
+                byte = rng.NextByte();
+            }
+        }
+    }
+
+    Chip8Fuzz fuzz(nullptr, cycles);
+    uint64_t instructions = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < bench; ++i) {
+        instructions += fuzz.Run(inputs[i % inputs.size()]);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "{\"executions\": " << bench
+        << ", \"cycles_per_execution\": " << cycles
+        << ", \"seconds\": " << elapsed.count()
+        << ", \"executions_per_second\": " << static_cast<uint64_t>(elapsed.count() > 0 ? bench / elapsed.count() : 0)
+        << ", \"instructions_per_second\": " << static_cast<uint64_t>(elapsed.count() > 0 ? instructions / elapsed.count() : 0)
+        << ", \"edges\": " << fuzz.EdgesHit()
+        << "}" << std::endl;
+    return 0;
+}